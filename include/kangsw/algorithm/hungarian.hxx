@@ -3,8 +3,17 @@
  */
 #pragma once
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <optional>
+#include <thread>
 #include <kangsw/container/ndarray.hxx>
+#include <kangsw/container/ndarray_ops.hxx>
+#include <kangsw/container/sparse_matrix.hxx>
 #include <kangsw/helpers/counter.hxx>
+#include <kangsw/helpers/for_each.hxx>
 #include <ranges>
 
 namespace kangsw::algorithm {
@@ -23,223 +32,584 @@ auto is_roughly_zero(Ty_ value) {
 }
 
 /**
- * 보류 ...
+ * Marks a row, or a column left unassigned.
+ */
+inline constexpr size_t hungarian_unassigned = size_t(-1);
+
+/**
+ * Cost of a forbidden pair; infinity for floating point, or the maximum for integral costs.
+ */
+template <typename NumTy_>
+constexpr NumTy_ hungarian_forbidden = std::numeric_limits<NumTy_>::has_infinity
+                                         ? std::numeric_limits<NumTy_>::infinity()
+                                         : std::numeric_limits<NumTy_>::max();
+
+template <typename NumTy_>
+struct hungarian_options {
+    /**
+     * If set, a row is left unassigned rather than paired above this cost; i.e. minimizes
+     * sum of assigned costs plus max_cost per unassigned row.
+     * Otherwise, as many rows as possible are assigned.
+     */
+    std::optional<NumTy_> max_cost;
+};
+
+/**
+ * Dual potentials of a solution, which prove its optimality:
+ * cost(r, c) - rows[r] - cols[c] is non-negative for every allowed pair, and zero for
+ * every assigned pair.
+ */
+template <typename DualTy_>
+struct hungarian_duals {
+    std::vector<DualTy_> rows;
+    std::vector<DualTy_> cols;
+};
+
+/**
+ * Dense cost rows
+ */
+template <typename NumTy_>
+struct _dense_costs {
+    ndarray_view<NumTy_ const, 2> view;
+
+    size_t rows() const noexcept { return view.dims()[0]; }
+    size_t cols() const noexcept { return view.dims()[1]; }
+    _dense_costs transpose() const noexcept { return {view.transpose()}; }
+
+    /**
+     * Pointer to elements of the row if they are contiguous, or nullptr.
+     */
+    NumTy_ const* row_data(size_t r) const noexcept { return cols() && view.strides()[1] == 1 ? &view(r, 0) : nullptr; }
+
+    /**
+     * Invokes fn(col, cost) for every column of the row, in ascending order.
+     */
+    template <typename Fn_>
+    void row(size_t r, Fn_&& fn) const {
+        for (size_t c = 0, n = cols(); c < n; ++c) { fn(c, view(r, c)); }
+    }
+};
+
+/**
+ * Sparse cost rows, where absent entries cost 'absent'.
+ */
+template <typename NumTy_, typename Index_>
+struct _sparse_costs {
+    sparse_matrix<NumTy_, sparse_format::csr, Index_> const& matrix;
+    NumTy_ absent;
+
+    size_t rows() const noexcept { return matrix.rows(); }
+    size_t cols() const noexcept { return matrix.cols(); }
+
+    template <typename Fn_>
+    void row(size_t r, Fn_&& fn) const {
+        auto const indices = matrix.indices(r);
+        auto const values = matrix.values(r);
+        for (size_t c = 0, k = 0, n = cols(); c < n; ++c) {
+            if (k < indices.size() && indices[k] == c) { fn(c, values[k++]); }
+            else { fn(c, absent); }
+        }
+    }
+};
+
+/**
  * Hungarian algorithm implementation class
+ *
+ * Kuhn-Munkres with potentials: rows are inserted one by one, each through the shortest
+ * augmenting path over reduced costs (Dijkstra on a dense graph), which takes O(n*m).
+ * Total O(n^2*m) time for n <= m, and O(n + m) memory besides the costs.
+ *
+ * Costs may be rectangular; if there are more rows than columns, the transposed problem is
+ * solved instead, which is free for dense costs. Rows left without a column are marked as
+ * hungarian_unassigned. Pairs of hungarian_forbidden cost are never assigned.
+ *
+ * Keep a solver across calls (e.g. one per tracking loop) to reuse its buffers, which only
+ * grow; costs are read through a const view, thus the caller keeps owning the matrix.
+ *
+ * @code
+ *   hungarian_solver<float> solver;
+ *   solver.reserve(2000, 2000);
+ *   for (;;) { auto const& pairs = solver(costs.view(), {.max_cost = gate}); ... }
+ * @endcode
+ *
+ * If costs change only a little between calls, resolve() starts from the previous pairs
+ * and duals, and augments only rows whose pairs were invalidated by the change.
+ *
+ * Square problems start from column reduction, which pairs most rows before any augmentation;
+ * give an execution policy to reduce blocks of rows in parallel. Scans over contiguous rows of
+ * floating point costs are vectorized with std::experimental::simd, if KANGSW_NDARRAY_USE_SIMD.
+ *
+ * is_zero is no longer required, since the potentials prove optimality by themselves;
+ * it is kept for source compatibility.
  */
-template <typename NumTy_, typename IsZero_>
+template <typename NumTy_, typename IsZero_ = bool (&)(NumTy_)>
 requires(std::is_integral_v<NumTy_> || std::is_floating_point_v<NumTy_>) //
   struct hungarian_solver {
+    // integral costs are reduced in signed 64-bit, since potentials may go negative
+    using dual_type = std::conditional_t<std::is_floating_point_v<NumTy_>, NumTy_, int64_t>;
+    using options_type = hungarian_options<NumTy_>;
+    using duals_type = hungarian_duals<dual_type>;
+
     hungarian_result_t const&
-    operator()(ndarray<NumTy_, 2>&& distances, IsZero_&& is_zero) {
-        if (distances.dims()[0] != distances.dims()[1]) {
-            throw std::logic_error{"Given distance should be square"};
-        };
+    operator()(ndarray<NumTy_, 2>&& distances, [[maybe_unused]] IsZero_&& is_zero) {
+        return (*this)(std::as_const(distances).view());
+    }
+
+    hungarian_result_t const& operator()(ndarray_view<NumTy_ const, 2> const& distances, options_type const& options = {}) {
+        return (*this)(std::execution::seq, distances, options);
+    }
+
+    template <typename ExPo_>
+    requires std::is_execution_policy_v<std::remove_cvref_t<ExPo_>>
+    hungarian_result_t const& operator()(ExPo_&& policy, ndarray_view<NumTy_ const, 2> const& distances, options_type const& options = {}) {
+        return _solve_any(policy, _dense_costs<NumTy_>{distances}, options);
+    }
+
+    hungarian_result_t const& operator()(ndarray<NumTy_, 2> const& distances, options_type const& options = {}) {
+        return (*this)(distances.view(), options);
+    }
+
+    template <typename Index_>
+    hungarian_result_t const& operator()(sparse_matrix<NumTy_, sparse_format::csr, Index_> const& costs, NumTy_ absent_cost, options_type const& options = {}) {
+        return _solve_sparse(costs, absent_cost, options, nullptr);
+    }
+
+    /**
+     * Re-optimizes from a previous solution, i.e. result() and duals() of an earlier call,
+     * which takes O(n*m) plus O(n*m) per row whose pair does not survive the change.
+     *
+     * Pairs which are still optimal under the previous column duals are kept, and the rest of
+     * rows are augmented as usual; thus the result is as optimal as a fresh solve.
+     * Rows and columns keep their indices across calls; any beyond the previous solution
+     * are taken as new ones, and any beyond current costs are dropped.
+     */
+    hungarian_result_t const& resolve(ndarray_view<NumTy_ const, 2> const& distances, hungarian_result_t const& assignment,
+                                      duals_type const& duals, options_type const& options = {}) {
+        _warm_start const warm{assignment, duals};
+        return _solve_any(std::execution::seq, _dense_costs<NumTy_>{distances}, options, &warm);
+    }
+
+    template <typename Index_>
+    hungarian_result_t const& resolve(sparse_matrix<NumTy_, sparse_format::csr, Index_> const& costs, NumTy_ absent_cost,
+                                      hungarian_result_t const& assignment, duals_type const& duals, options_type const& options = {}) {
+        _warm_start const warm{assignment, duals};
+        return _solve_sparse(costs, absent_cost, options, &warm);
+    }
+
+    /**
+     * Re-optimizes from the latest call of this solver.
+     */
+    hungarian_result_t const& resolve(ndarray_view<NumTy_ const, 2> const& distances, options_type const& options = {}) {
+        return resolve(distances, _result, _duals, options);
+    }
+
+    /**
+     * Preallocates buffers for problems up to num_rows x num_cols, including gating.
+     */
+    void reserve(size_t num_rows, size_t num_cols) {
+        auto const n = std::min(num_rows, num_cols), m = std::max(num_rows, num_cols);
+        auto const num_total = m + n + 1;
+
+        _result.reserve(m), _scratch.reserve(m);
+        _row_dual.reserve(n);
+        _col_dual.reserve(num_total), _row4col.reserve(num_total), _way.reserve(num_total);
+        _min_slack.reserve(num_total), _used.reserve(num_total);
+        _col4row.reserve(n), _path.reserve(num_total);
+        _block_min.reserve(_max_blocks(n) * m), _block_arg.reserve(_max_blocks(n) * m);
+        _duals.rows.reserve(num_rows), _duals.cols.reserve(num_cols);
+    }
+
+    /**
+     * Result of the latest call, which is valid until the next call.
+     */
+    hungarian_result_t const& result() const noexcept { return _result; }
+
+    /**
+     * Duals of the latest call, in the same orientation as its costs.
+     */
+    duals_type const& duals() const noexcept { return _duals; }
+
+private:
+    static constexpr size_t _none = hungarian_unassigned;
+    static constexpr size_t _pad = _none - 1;
+    static constexpr dual_type _inf = std::numeric_limits<dual_type>::has_infinity
+                                        ? std::numeric_limits<dual_type>::infinity()
+                                        : std::numeric_limits<dual_type>::max();
+
+    struct _warm_start {
+        hungarian_result_t const& assignment;
+        duals_type const& duals;
+    };
 
-        // Reset solver
-        _distances = std::move(distances);
-        _len = _distances.dims()[0];
+    template <typename ExPo_, typename Costs_>
+    hungarian_result_t const& _solve_any(ExPo_&& policy, Costs_ const& costs, options_type const& options, _warm_start const* warm = nullptr) {
+        if (costs.rows() <= costs.cols()) { return _solve(policy, costs, options, warm, false); }
 
-        _zeros.reshape(_distances.dims());
-        _line_zeros_rows.resize(_len);
-        _line_zeros_cols.resize(_len);
-        _line_cover_mask.reshape(_distances.dims());
+        _solve(policy, costs.transpose(), options, warm, true);
+        return _transpose_result(costs.rows());
+    }
 
-        _result.clear();
-        _result.resize(_len);
+    template <typename Index_>
+    hungarian_result_t const& _solve_sparse(sparse_matrix<NumTy_, sparse_format::csr, Index_> const& costs, NumTy_ absent_cost,
+                                            options_type const& options, _warm_start const* warm) {
+        if (costs.rows() <= costs.cols()) { return _solve(std::execution::seq, _sparse_costs<NumTy_, Index_>{costs, absent_cost}, options, warm, false); }
 
-        // initial step
-        for (size_t row = 0; row < _len; ++row) { _row_zero(row); }
-        for (size_t col = 0; col < _len; ++col) { _col_zero(col); }
+        auto const transposed = costs.transpose().to_csr();
+        _solve(std::execution::seq, _sparse_costs<NumTy_, Index_>{transposed, absent_cost}, options, warm, true);
+        return _transpose_result(costs.rows());
+    }
 
-        while (!_is_optimal(is_zero)) {
-            _step1();
+    hungarian_result_t const& _transpose_result(size_t num_rows) {
+        _scratch.assign(_result.begin(), _result.end());
+        _result.assign(num_rows, _none);
+        for (size_t col = 0; col < _scratch.size(); ++col) {
+            if (_scratch[col] != _none) { _result[_scratch[col]] = col; }
         }
+        return _result;
+    }
 
-        _result.resize(_len);
+    bool _is_forbidden(NumTy_ cost) const noexcept {
+        return !(cost < hungarian_forbidden<NumTy_>) || (_has_limit && dual_type(cost) > _limit);
+    }
 
-        // fill zeros again
-        for (auto& idx : counter(_distances.dims())) {
-            _zeros[idx] = is_zero(_distances[idx]);
+    /**
+     * With max_cost, every row gets a private dummy column of that cost, after the real
+     * columns; being matched to it means the row is unassigned. Without it, forbidden pairs
+     * may leave rows unassigned too, thus dummies are given the cost of _unassigned_cost().
+     */
+    template <typename ExPo_, typename Costs_>
+    hungarian_result_t const& _solve(ExPo_&& policy, Costs_ const& costs, options_type const& options, _warm_start const* warm, bool transposed) {
+        auto const num_rows = costs.rows(), num_cols = costs.cols();
+        _has_limit = options.max_cost.has_value();
+        _limit = _has_limit ? dual_type(*options.max_cost) : _unassigned_cost(costs);
+        _num_cols = num_cols;
+        _num_dummies = _limit < _inf ? num_rows : 0;
+
+        // the last column is virtual root of every augmenting path.
+        auto const num_total = num_cols + _num_dummies + 1;
+        _row_dual.assign(num_rows, 0);
+        _col_dual.assign(num_total, 0);
+        _row4col.assign(num_total, _none);
+        _way.resize(num_total);
+        _min_slack.resize(num_total);
+        _used.resize(num_total);
+        _col4row.assign(num_rows, _none);
+
+        auto const num_free_pads = warm ? _restore(costs, *warm, transposed) : 0;
+        if (!warm && !_num_dummies && num_rows == num_cols) { _reduce_columns(policy, costs); }
+        for (size_t row = 0; row < num_rows; ++row) {
+            if (_col4row[row] == _none) { _augment(costs, row); }
         }
+        for (size_t i = 0; i < num_free_pads; ++i) { _augment(costs, _pad); }
+
+        // previous solution may alias these, thus they are written only after restoration
+        auto& row_duals = transposed ? _duals.cols : _duals.rows;
+        auto& col_duals = transposed ? _duals.rows : _duals.cols;
+        row_duals.assign(_row_dual.begin(), _row_dual.end());
+        col_duals.assign(_col_dual.begin(), _col_dual.begin() + num_cols);
 
-        _occupation.clear();
-        _occupation.resize(_len);
-        _find_optimal();
+        _result.assign(num_rows, _none);
+        for (size_t col = 0; col < num_cols; ++col) {
+            if (_row4col[col] < num_rows) { _result[_row4col[col]] = col; }
+        }
         return _result;
     }
 
-private:
-    enum class line_t {
-        none,
-        row,
-        col
-    };
+    /**
+     * Cost of being unassigned without max_cost, which exceeds any difference between sums of
+     * allowed costs; then the fewest rows are left unassigned, and the cheapest of such pairs
+     * are taken. Returns _inf if every pair is allowed, where rows never need a dummy.
+     */
+    template <typename Costs_>
+    dual_type _unassigned_cost(Costs_ const& costs) const {
+        auto lo = _inf, hi = -_inf;
+        bool has_forbidden = false;
+        for (size_t row = 0; row < costs.rows(); ++row) {
+            costs.row(row, [&](size_t, NumTy_ cost) {
+                if (_is_forbidden(cost)) { return void(has_forbidden = true); }
+                lo = std::min(lo, dual_type(cost)), hi = std::max(hi, dual_type(cost));
+            });
+        }
 
-    auto _row_subtr(size_t row, NumTy_ val) {
-        for (size_t i = 0; i < _len; i++) { _distances(row, i) -= val; }
-    };
-    auto _col_subtr(size_t col, NumTy_ val) {
-        for (size_t i = 0; i < _len; i++) { _distances(i, col) -= val; }
-    };
-    auto _row_min(size_t row) const {
-        NumTy_ min = std::numeric_limits<NumTy_>::max();
-        for (size_t i = 0; i < _len; i++) { min = std::min(min, _distances(row, i)); }
-        return min;
-    };
-    auto _col_min(size_t col) const {
-        NumTy_ min = std::numeric_limits<NumTy_>::max();
-        for (size_t i = 0; i < _len; i++) { min = std::min(min, _distances(i, col)); }
-        return min;
-    };
-    auto _col_zero(size_t col) {
-        return _col_subtr(col, _col_min(col));
-    };
-    auto _row_zero(size_t row) {
-        return _row_subtr(row, _row_min(row));
-    };
-    auto _col_sum(size_t col) const {
-        NumTy_ sum = {};
-        for (size_t i = 0; i < _len; i++) { sum += _distances(i, col); }
-        return sum;
-    };
-    auto _row_sum(size_t row) const {
-        NumTy_ sum = {};
-        for (size_t i = 0; i < _len; i++) { sum += _distances(row, i); }
-        return sum;
-    };
+        if (!has_forbidden) { return _inf; }
+        if (!(lo < _inf)) { return 1; }
 
-    // optimal check
-    // check if we can erase all zeros GE than 'len' lines
-    bool _is_optimal(IsZero_& is_zero) {
-        // fill zeros
-        for (auto& idx : counter(_distances.dims())) {
-            _zeros[idx] = is_zero(_distances[idx]);
+        // integral costs saturate well below _inf, so that slacks never overflow
+        auto const num_rows = dual_type(costs.rows()), top = std::max<dual_type>(hi, 0);
+        if constexpr (std::is_integral_v<dual_type>) {
+            constexpr auto ceiling = _inf / 4;
+            if (hi - lo > (ceiling - top - 1) / num_rows) { return ceiling; }
         }
+        return (hi - lo) * num_rows + top + 1;
+    }
+
+    /**
+     * Reduces each column by its minimum, and pairs it with the row of the minimum unless the row
+     * is paired already; every pair is then tight with zero row dual. Blocks of rows are scanned
+     * in parallel by the policy, each into its own partial minimums, thus costs are read row by
+     * row only once.
+     *
+     * Every pair is allowed here, since forbidden pairs bring dummy columns in.
+     */
+    template <typename ExPo_, typename Costs_>
+    void _reduce_columns(ExPo_&& policy, Costs_ const& costs) {
+        auto const num_rows = costs.rows(), num_cols = _num_cols;
+        if (num_rows == 0) { return; }
+
+        constexpr bool sequential = std::is_same_v<std::remove_cvref_t<ExPo_>, std::execution::sequenced_policy>;
+        auto const num_blocks = sequential ? 1 : _max_blocks(num_rows);
+        _block_min.assign(num_blocks * num_cols, _inf);
+        _block_arg.assign(num_blocks * num_cols, _none);
+
+        iota rows(num_rows);
+        for_each_partition(
+          policy, rows.begin(), rows.end(),
+          [&](size_t row, size_t block) {
+              auto const mins = _block_min.data() + block * num_cols;
+              auto const args = _block_arg.data() + block * num_cols;
+              costs.row(row, [&](size_t c, NumTy_ cost) {
+                  if (dual_type(cost) < mins[c]) { mins[c] = dual_type(cost), args[c] = row; }
+              });
+          },
+          num_blocks);
+
+        // blocks are in order of rows, thus the first minimum wins as a scan over the column would.
+        for (size_t col = 0; col < num_cols; ++col) {
+            auto best = _inf;
+            auto row = _none;
+            for (size_t block = 0; block < num_blocks; ++block) {
+                if (_block_min[block * num_cols + col] < best) { best = _block_min[block * num_cols + col], row = _block_arg[block * num_cols + col]; }
+            }
+
+            _col_dual[col] = best;
+            if (_col4row[row] == _none) { _col4row[row] = col, _row4col[col] = row; }
+        }
+    }
+
+    static size_t _max_blocks(size_t num_rows) noexcept {
+        return std::clamp<size_t>(num_rows / 64, 1, std::max(1u, std::thread::hardware_concurrency()));
+    }
 
-        // calculate each line's containing zero count
-        std::fill(_line_zeros_rows.begin(), _line_zeros_rows.end(), 0);
-        std::fill(_line_zeros_cols.begin(), _line_zeros_cols.end(), 0);
+    /**
+     * Takes over pairs of the previous solution which are still tight under its column duals;
+     * rows of the rest are augmented again, and their columns keep their duals meanwhile.
+     *
+     * Shifting duals so that the maximum is zero keeps them as _augment leaves them. Then free
+     * columns at zero are held by padding rows of zero cost, as if the problem were square, so
+     * that a freed column can't be lifted to zero (which would release every row preferring
+     * it) but be taken by an augmenting path which moves a padding row.
+     * With dummies, every row without a pair tries its dummy, which is kept if no real column is
+     * cheaper. Square problems without dummies need no padding, since every pair is allowed and
+     * every column gets paired again; a freed column of any dual is then taken as usual.
+     */
+    template <typename Costs_>
+    size_t _restore(Costs_ const& costs, _warm_start const& warm, bool transposed) {
+        auto const num_rows = costs.rows(), root = _row4col.size() - 1;
+        auto const& prev_duals = transposed ? warm.duals.rows : warm.duals.cols;
+        auto const num_prev_cols = std::min(prev_duals.size(), _num_cols);
+        auto const shift = num_prev_cols ? *std::max_element(prev_duals.begin(), prev_duals.begin() + num_prev_cols) : dual_type{};
+        for (size_t col = 0; col < num_prev_cols; ++col) { _col_dual[col] = prev_duals[col] - shift; }
+
+        auto const& prev = warm.assignment;
+        for (size_t i = 0; i < prev.size(); ++i) {
+            if (prev[i] == _none) { continue; }
+            auto const row = transposed ? prev[i] : i, col = transposed ? i : prev[i];
+            if (row >= num_rows || col >= _num_cols || _col4row[row] != _none || _row4col[col] != _none) { continue; }
+            _col4row[row] = col, _row4col[col] = row;
+        }
 
-        for (size_t idx = 0; idx < _len; idx++) {
-            for (size_t row = idx, col = 0; col < _len; col++) {
-                _line_zeros_rows[idx] += _zeros(row, col);
+        for (size_t row = 0; row < num_rows; ++row) {
+            auto col = _col4row[row];
+            if (col == _none && !_num_dummies) { continue; }
+            if (col == _none) { col = _num_cols + row; }
+
+            // own dummy column has zero dual
+            auto min_reduced = _limit, paired = col < _num_cols ? _inf : _limit;
+            costs.row(row, [&](size_t c, NumTy_ cost) {
+                if (_is_forbidden(cost)) { return; }
+                auto const reduced = dual_type(cost) - _col_dual[c];
+                min_reduced = std::min(min_reduced, reduced);
+                if (c == col) { paired = reduced; }
+            });
+
+            if (paired < _inf && _is_tight(paired, min_reduced)) {
+                _col4row[row] = col, _row4col[col] = row, _row_dual[row] = paired;
             }
-            for (size_t col = idx, row = 0; row < _len; row++) {
-                _line_zeros_cols[idx] += _zeros(row, col);
+            else if (col < _num_cols) {
+                _col4row[row] = _none, _row4col[col] = _none;
             }
         }
 
-        // erase maximums from line_zeros
-        _lines.clear();
-        for (;;) {
-            auto it_rmax = std::ranges::max_element(_line_zeros_rows);
-            auto it_cmax = std::ranges::max_element(_line_zeros_cols);
-
-            // erase given zeros covered by given line.
-            // dethermines whether it is row or column, by comparing maximum values of rows/cols
-            if (*it_rmax > *it_cmax) {
-                auto row = it_rmax - _line_zeros_rows.begin();
-                _lines.emplace_back(line_t::row, row);
-
-                *it_rmax = 0;
-                for (size_t col = 0; col < _len; ++col) {
-                    if (auto& target = _zeros(row, col)) {
-                        target = false;
-                        _line_zeros_cols[col] -= 1;
-                    }
-                }
-            }
-            else {
-                auto col = it_cmax - _line_zeros_cols.begin();
-                _lines.emplace_back(line_t::col, col);
-
-                *it_cmax = 0;
-                for (size_t row = 0; row < _len; ++row) {
-                    if (auto& target = _zeros(row, col)) {
-                        target = false;
-                        _line_zeros_rows[row] -= 1;
+        auto num_pads = root - num_rows;
+        for (size_t col = 0; col < root && num_pads; ++col) {
+            if (_row4col[col] == _none && _col_dual[col] == 0) { _row4col[col] = _pad, --num_pads; }
+        }
+        return num_pads;
+    }
+
+    static bool _is_tight(dual_type paired, dual_type min_reduced) noexcept {
+        if constexpr (std::is_floating_point_v<dual_type>) {
+            auto const tolerance = 64 * std::numeric_limits<dual_type>::epsilon() * std::max<dual_type>(1, std::abs(paired));
+            return paired - min_reduced <= tolerance;
+        }
+        else {
+            return paired == min_reduced;
+        }
+    }
+
+    static constexpr bool _marks_used = std::is_floating_point_v<dual_type>;
+
+    template <typename Costs_>
+    static NumTy_ const* _row_data(Costs_ const& costs, size_t row) noexcept {
+        if constexpr (_marks_used && std::is_same_v<Costs_, _dense_costs<NumTy_>>) { return costs.row_data(row); }
+        else { return nullptr; }
+    }
+
+    /**
+     * Relaxes real columns through a contiguous row, and returns the first minimum slack among
+     * unused columns with its column. Used columns have NaN slack, which fails every comparison,
+     * thus lanes need no mask of them.
+     */
+    std::pair<dual_type, size_t> _scan(NumTy_ const* costs, dual_type row_dual, size_t col) {
+        auto const n = _num_cols;
+        auto const col_dual = _col_dual.data();
+        auto const min_slack = _min_slack.data();
+        auto best = _inf;
+        size_t i = 0;
+
+#if KANGSW_NDARRAY_USE_SIMD
+        if constexpr (_marks_used) {
+            namespace stdx = std::experimental;
+            using simd_type = stdx::native_simd<dual_type>;
+            constexpr auto width = simd_type::size();
+
+            simd_type lanes_best = _inf;
+            for (; i + width <= n; i += width) {
+                simd_type const cost(costs + i, stdx::element_aligned);
+                simd_type const slack = cost - row_dual - simd_type(col_dual + i, stdx::element_aligned);
+                simd_type slacks(min_slack + i, stdx::element_aligned);
+
+                auto improved = slack < slacks;
+                if (_has_limit) { improved = improved && !(cost > simd_type(_limit)); }
+                if (stdx::any_of(improved)) {
+                    stdx::where(improved, slacks) = slack;
+                    slacks.copy_to(min_slack + i, stdx::element_aligned);
+                    for (size_t k = 0; k < width; ++k) {
+                        if (improved[k]) { _way[i + k] = col; }
                     }
                 }
+                stdx::where(slacks < lanes_best, lanes_best) = slacks;
             }
+            best = stdx::hmin(lanes_best);
+        }
+#endif
 
-            // check if there's no zero.
-            if (
-              std::ranges::find(_line_zeros_rows, 1) == _line_zeros_rows.end()
-              && std::ranges::find(_line_zeros_cols, 1) == _line_zeros_cols.end()) {
-                break;
-            }
+        for (; i < n; ++i) {
+            auto const slack = costs[i] - row_dual - col_dual[i];
+            if (slack < min_slack[i] && !(_has_limit && costs[i] > _limit)) { min_slack[i] = slack, _way[i] = col; }
+            if (min_slack[i] < best) { best = min_slack[i]; }
         }
 
-        return _lines.size() >= _len;
+        if (!(best < _inf)) { return {_inf, _none}; }
+        return {best, size_t(std::find(min_slack, min_slack + n, best) - min_slack)};
     }
 
-    // modifies distance matrix
-    void _step1() {
-        // create line-covering mask
-        std::ranges::fill(_line_cover_mask, 0);
-        for (auto& line : _lines) {
-            if (line.first == line_t::row) {
-                for (auto col : counter(_len)) { ++_line_cover_mask(line.second, col); }
+    /**
+     * Padding row, which only appears after _restore(), costs zero for every column; its dual
+     * is implicitly negation of the dual of its column.
+     */
+    template <typename Costs_>
+    void _augment(Costs_ const& costs, size_t row) {
+        auto const root = _row4col.size() - 1;
+        _row4col[root] = row, _col_dual[root] = 0;
+        std::fill(_min_slack.begin(), _min_slack.end(), _inf);
+        std::fill(_used.begin(), _used.end(), false);
+
+        size_t col = root;
+        _path.clear();
+        do {
+            _used[col] = true, _path.push_back(col);
+            if constexpr (_marks_used) { _min_slack[col] = std::numeric_limits<dual_type>::quiet_NaN(); }
+
+            auto const cur_row = _row4col[col];
+            auto const row_dual = cur_row == _pad ? -_col_dual[col] : _row_dual[cur_row];
+            auto delta = _inf;
+            size_t next = _none;
+
+            auto relax = [&](size_t c, dual_type cost) {
+                auto const slack = cost - row_dual - _col_dual[c];
+                if (slack < _min_slack[c]) { _min_slack[c] = slack, _way[c] = col; }
+            };
+
+            if (cur_row == _pad) {
+                for (size_t c = 0; c < root; ++c) {
+                    if (_used[c]) { continue; }
+                    relax(c, 0);
+                    if (_min_slack[c] < delta) { delta = _min_slack[c], next = c; }
+                }
             }
             else {
-                for (auto row : counter(_len)) { ++_line_cover_mask(row, line.second); }
-            }
-        }
+                if (auto const data = _row_data(costs, cur_row)) { std::tie(delta, next) = _scan(data, row_dual, col); }
+                else {
+                    costs.row(cur_row, [&](size_t c, NumTy_ cost) {
+                        if (_used[c]) { return; }
+                        if (!_is_forbidden(cost)) { relax(c, dual_type(cost)); }
+                        if (_min_slack[c] < delta) { delta = _min_slack[c], next = c; }
+                    });
+                }
 
-        // find minimum from line-covering mask
-        auto min_value = std::numeric_limits<NumTy_>::max();
-        for (auto index : counter(_distances.dims())) {
-            if (_line_cover_mask[index] == 0) {
-                min_value = std::min(_distances[index], min_value);
+                if (_num_dummies) {
+                    if (auto const dummy = _num_cols + cur_row; !_used[dummy]) { relax(dummy, _limit); }
+                    for (size_t c = _num_cols; c < root; ++c) {
+                        if (!_used[c] && _min_slack[c] < delta) { delta = _min_slack[c], next = c; }
+                    }
+                }
             }
-        }
 
-        // discount minimum value from non-line-covered area,
-        //and increase double-covered area's value
-        for (auto index : counter(_distances.dims())) {
-            if (_line_cover_mask[index] == 0) {
-                _distances[index] -= min_value;
+            if (next == _none) {
+                // not reached, since either every pair is allowed or every row has its dummy.
+                _row4col[root] = _none;
+                return;
             }
-            else if (_line_cover_mask[index] == 2) {
-                _distances[index] += min_value;
+
+            // duals move only on the path, and unreached columns stay unreached.
+            for (auto c : _path) {
+                if (_row4col[c] != _pad) { _row_dual[_row4col[c]] += delta; }
+                _col_dual[c] -= delta;
             }
-        }
-    }
+            for (auto& slack : _min_slack) { slack = slack < _inf ? slack - delta : slack; }
 
-    // generate optimal result
-    bool _find_optimal(size_t row = 0) {
-        for (size_t col = 0; col < _len; col++) {
-            if (!_zeros(row, col)) { continue; }
-            if (_occupation[col]) { continue; }
+            col = next;
+        } while (_row4col[col] != _none);
 
-            _occupation[col] = true;
-            if (row + 1 == _len || _find_optimal(row + 1)) {
-                _result[row] = col;
-                return true;
-            }
-            _occupation[col] = false;
+        // flip the path
+        while (col != root) {
+            auto const prev = _way[col];
+            _row4col[col] = _row4col[prev];
+            col = prev;
         }
-
-        return false;
+        _row4col[root] = _none;
     }
 
-private:
-    struct _search_stack_entity {
-        size_t row;
-        size_t col;
-    };
-
 private:
     hungarian_result_t _result;
-    std::vector<_search_stack_entity> _search_stack;
-    ndarray<NumTy_, 2> _distances;
-    ndarray<int8_t, 2> _zeros;
-    std::vector<size_t> _line_zeros_rows;
-    std::vector<size_t> _line_zeros_cols;
-    std::vector<std::pair<line_t, size_t>> _lines;
-    ndarray<int8_t, 2> _line_cover_mask;
-    std::vector<bool> _occupation;
-    size_t _len;
+    hungarian_result_t _scratch;
+    std::vector<dual_type> _row_dual;
+    std::vector<dual_type> _col_dual;
+    std::vector<size_t> _row4col;
+    std::vector<size_t> _way;
+    std::vector<dual_type> _min_slack;
+    std::vector<bool> _used;
+    std::vector<size_t> _col4row;
+    std::vector<size_t> _path;
+    std::vector<dual_type> _block_min;
+    std::vector<size_t> _block_arg;
+    duals_type _duals;
+
+    bool _has_limit = false;
+    dual_type _limit = _inf;
+    size_t _num_cols = 0;
+    size_t _num_dummies = 0;
 };
 
 /**
@@ -252,6 +622,50 @@ auto hungarian(ndarray<NumTy_, 2>&& distances, IsZero_&& is_zero = is_roughly_ze
     return hungarian_solver<NumTy_, IsZero_>{}(std::move(distances), std::move(is_zero));
 }
 
+/**
+ * Calculate hungarian pairs of rectangular costs, optionally gated by max_cost.
+ * Each element of the result is the column of the row, or hungarian_unassigned.
+ */
+template <typename NumTy_>
+requires std::is_integral_v<NumTy_> || std::is_floating_point_v<NumTy_>
+auto hungarian(ndarray<NumTy_, 2> const& distances, hungarian_options<NumTy_> const& options) -> hungarian_result_t //
+{
+    return hungarian_solver<NumTy_>{}(distances.view(), options);
+}
+
+/**
+ * Same as above, where large matrix passes run under given execution policy.
+ */
+template <typename ExPo_, typename NumTy_>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExPo_>> && (std::is_integral_v<NumTy_> || std::is_floating_point_v<NumTy_>)
+auto hungarian(ExPo_&& policy, ndarray<NumTy_, 2> const& distances, hungarian_options<NumTy_> const& options = {}) -> hungarian_result_t //
+{
+    return hungarian_solver<NumTy_>{}(policy, distances.view(), options);
+}
+
+/**
+ * Calculate hungarian pairs over sparse costs, where absent entries cost absent_cost.
+ * Rows are scanned in place, thus costs are never expanded into dense matrix.
+ */
+template <typename NumTy_, sparse_format Format_, typename Index_, typename IsZero_ = bool (&)(NumTy_)>
+requires std::is_integral_v<NumTy_> || std::is_floating_point_v<NumTy_>
+auto hungarian(sparse_matrix<NumTy_, Format_, Index_> const& costs, NumTy_ absent_cost, [[maybe_unused]] IsZero_&& is_zero = is_roughly_zero<NumTy_>) -> hungarian_result_t //
+{
+    if constexpr (Format_ == sparse_format::csr) { return hungarian_solver<NumTy_>{}(costs, absent_cost); }
+    else { return hungarian_solver<NumTy_>{}(costs.to_csr(), absent_cost); }
+}
+
+/**
+ * Calculate hungarian pairs over sparse costs, where absent entries are forbidden.
+ */
+template <typename NumTy_, sparse_format Format_, typename Index_>
+requires std::is_integral_v<NumTy_> || std::is_floating_point_v<NumTy_>
+auto hungarian(sparse_matrix<NumTy_, Format_, Index_> const& costs, hungarian_options<NumTy_> const& options = {}) -> hungarian_result_t //
+{
+    if constexpr (Format_ == sparse_format::csr) { return hungarian_solver<NumTy_>{}(costs, hungarian_forbidden<NumTy_>, options); }
+    else { return hungarian_solver<NumTy_>{}(costs.to_csr(), hungarian_forbidden<NumTy_>, options); }
+}
+
 /**
  * 
  */
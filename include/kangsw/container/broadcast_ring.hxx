@@ -0,0 +1,257 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include "kangsw/container/spsc_circular_queue.hxx"
+
+namespace kangsw {
+/**
+ * Bounded lock-free ring which delivers every event to all of its consumers, while
+ * storing each event only once. (Disruptor style)
+ *
+ * Like circular_queue<Ty_, true>, capacity is rounded up to power of two, and every
+ * position is a monotonically increasing sequence which is masked on access.
+ * Each consumer owns its read sequence, and writers never overwrite a slot until the
+ * slowest consumer has passed it.
+ *
+ * If MultiWriter_ is set, any number of threads may push concurrently; otherwise,
+ * push 계열 함수는 하나의 스레드에서만 호출해야 합니다.
+ * Each consumer handle must be used by one thread at a time.
+ *
+ * Construction of events must not throw.
+ */
+template <typename Ty_, bool MultiWriter_ = false>
+class broadcast_ring {
+public:
+    using value_type = Ty_;
+    class consumer;
+
+public:
+    explicit broadcast_ring(size_t capacity, size_t max_consumers = 8) :
+        _capacity(capacity ? std::bit_ceil(capacity) : throw std::invalid_argument("capacity must be positive")),
+        _num_readers(max_consumers),
+        _readers(std::make_unique<_reader_t[]>(max_consumers)),
+        _data(std::allocator<Ty_>{}.allocate(_capacity)) {
+        if constexpr (MultiWriter_) { _stamps = std::make_unique<std::atomic_size_t[]>(_capacity); }
+    }
+
+    broadcast_ring(const broadcast_ring&) = delete;
+    broadcast_ring& operator=(const broadcast_ring&) = delete;
+
+    // every consumer and writer must be done before destruction.
+    ~broadcast_ring() {
+        auto const end = _cursor.load();
+        for (auto seq = end - std::min(end, _capacity); seq != end; ++seq) { std::destroy_at(_data + _slot(seq)); }
+        std::allocator<Ty_>{}.deallocate(_data, _capacity);
+    }
+
+public:
+    /**
+     * Publishes an event, unless it'd overwrite one which isn't read by every consumer yet.
+     */
+    template <typename... Args_>
+    bool try_emplace(Args_&&... args) {
+        auto seq = _cursor.load(std::memory_order_relaxed);
+        do {
+            if (_is_gated(seq)) { return false; }
+        } while (MultiWriter_ && !_cursor.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed));
+
+        _write(seq, std::forward<Args_>(args)...);
+        return true;
+    }
+
+    /**
+     * Publishes an event, waiting for the slowest consumer if the ring is full.
+     */
+    template <typename... Args_>
+    void emplace(Args_&&... args) {
+        auto const seq = MultiWriter_ ? _cursor.fetch_add(1, std::memory_order_relaxed) : _cursor.load(std::memory_order_relaxed);
+        while (_is_gated(seq)) { std::this_thread::yield(); }
+
+        _write(seq, std::forward<Args_>(args)...);
+    }
+
+    bool try_push(Ty_ const& s) { return try_emplace(s); }
+    bool try_push(Ty_&& s) { return try_emplace(std::move(s)); }
+    void push(Ty_ const& s) { emplace(s); }
+    void push(Ty_&& s) { emplace(std::move(s)); }
+
+    /**
+     * Registers new consumer, which receives events published after this call.
+     * Throws if every consumer slot is occupied.
+     */
+    consumer subscribe() {
+        for (size_t i = 0; i < _num_readers; ++i) {
+            auto& reader = _readers[i];
+            if (bool expected = false; !reader.active.compare_exchange_strong(expected, true)) { continue; }
+
+            // any writer which didn't see this consumer active, computed its gate
+            //from a cursor not greater than the one read here.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto const seq = _cursor.load();
+            reader.seq.store(seq, std::memory_order_release);
+            return consumer{this, i, seq};
+        }
+
+        throw std::logic_error("no more consumer slot available");
+    }
+
+    constexpr size_t capacity() const noexcept { return _capacity; }
+
+    size_t num_consumers() const noexcept {
+        size_t n = 0;
+        for (size_t i = 0; i < _num_readers; ++i) { n += _readers[i].active.load(std::memory_order_relaxed); }
+        return n;
+    }
+
+public:
+    class consumer {
+    public:
+        consumer() noexcept = default;
+        consumer(consumer&& op) noexcept { *this = std::move(op); }
+        consumer& operator=(consumer&& op) noexcept {
+            std::swap(_owner, op._owner);
+            std::swap(_index, op._index);
+            std::swap(_seq, op._seq);
+            return *this;
+        }
+
+        ~consumer() {
+            if (_owner) { _owner->_readers[_index].active.store(false, std::memory_order_release); }
+        }
+
+    public:
+        /**
+         * Number of published events which are not consumed yet.
+         */
+        size_t available() const { return _owner->_available(_seq, ~size_t{}); }
+
+        /**
+         * Up to max_count pending events as (at most) two contiguous spans, in order.
+         * They stay valid until pop().
+         */
+        std::pair<std::span<Ty_ const>, std::span<Ty_ const>> peek(size_t max_count = ~size_t{}) const {
+            auto const n = _owner->_available(_seq, max_count);
+            auto const slot = _owner->_slot(_seq);
+            auto const n_first = std::min(n, _owner->_capacity - slot);
+            return {{_owner->_data + slot, n_first}, {_owner->_data, n - n_first}};
+        }
+
+        /**
+         * Releases front n events, which must have been peeked.
+         */
+        void pop(size_t n = 1) {
+            _seq += n;
+            _owner->_readers[_index].seq.store(_seq, std::memory_order_release);
+        }
+
+        bool try_pop(Ty_& out) {
+            auto [a, b] = peek(1);
+            if (a.empty()) { return false; }
+            out = a.front();
+            return pop(), true;
+        }
+
+        /**
+         * Invokes fn on every pending event (at most max_count), then releases them at once.
+         * @return number of consumed events
+         */
+        template <typename Fn_>
+        size_t consume(Fn_&& fn, size_t max_count = ~size_t{}) {
+            auto [a, b] = peek(max_count);
+            for (auto& e : a) { fn(e); }
+            for (auto& e : b) { fn(e); }
+            pop(a.size() + b.size());
+            return a.size() + b.size();
+        }
+
+        explicit operator bool() const noexcept { return _owner != nullptr; }
+
+    private:
+        friend class broadcast_ring;
+        consumer(broadcast_ring* owner, size_t index, size_t seq) noexcept :
+            _owner(owner), _index(index), _seq(seq) {}
+
+        broadcast_ring* _owner = nullptr;
+        size_t _index = 0;
+        size_t _seq = 0;
+    };
+
+private:
+    size_t _slot(size_t seq) const noexcept { return seq & (_capacity - 1); }
+
+    /**
+     * Whether writing seq would overwrite an event which isn't consumed yet.
+     * Gate sequence is cached, and consumers are scanned only when it looks full.
+     * The cache is published with release, since other writers overwrite slots on it
+     * without scanning consumers themselves.
+     */
+    bool _is_gated(size_t seq) {
+        if (seq < _gate_cached.load(std::memory_order_acquire) + _capacity) { return false; }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto gate = seq;
+        for (size_t i = 0; i < _num_readers; ++i) {
+            auto& reader = _readers[i];
+            if (reader.active.load(std::memory_order_relaxed)) { gate = std::min(gate, reader.seq.load(std::memory_order_acquire)); }
+        }
+
+        _gate_cached.store(gate, std::memory_order_release);
+        return seq >= gate + _capacity;
+    }
+
+    template <typename... Args_>
+    void _write(size_t seq, Args_&&... args) {
+        auto const slot = _slot(seq);
+        if constexpr (MultiWriter_) {
+            // another writer may be still in progress on this slot, one lap behind.
+            while (seq >= _capacity && _stamps[slot].load(std::memory_order_acquire) != seq - _capacity + 1) {
+                std::this_thread::yield();
+            }
+        }
+
+        if (seq >= _capacity) { std::destroy_at(_data + slot); }
+        std::construct_at(_data + slot, std::forward<Args_>(args)...);
+
+        if constexpr (MultiWriter_) {
+            _stamps[slot].store(seq + 1, std::memory_order_release);
+        }
+        else {
+            _cursor.store(seq + 1, std::memory_order_release);
+        }
+    }
+
+    size_t _available(size_t seq, size_t max_count) const {
+        if constexpr (MultiWriter_) {
+            // events may be published out of order; count only the contiguous ones.
+            size_t n = 0;
+            while (n < max_count && n < _capacity && _stamps[_slot(seq + n)].load(std::memory_order_acquire) == seq + n + 1) { ++n; }
+            return n;
+        }
+        else {
+            return std::min(max_count, _cursor.load(std::memory_order_acquire) - seq);
+        }
+    }
+
+private:
+    struct alignas(_cache_line_size) _reader_t {
+        std::atomic_size_t seq = 0;
+        std::atomic_bool active = false;
+    };
+
+    // published sequence for single writer, or claimed sequence for multi writer
+    alignas(_cache_line_size) std::atomic_size_t _cursor = 0;
+    alignas(_cache_line_size) std::atomic_size_t _gate_cached = 0;
+
+    alignas(_cache_line_size) size_t const _capacity;
+    size_t const _num_readers;
+    std::unique_ptr<_reader_t[]> _readers;
+    std::unique_ptr<std::atomic_size_t[]> _stamps; // seq + 1 of the event published on each slot
+    Ty_* const _data;
+};
+} // namespace kangsw
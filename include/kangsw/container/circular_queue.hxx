@@ -1,18 +1,36 @@
 #pragma once
-#include <array>
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <utility>
 
 namespace kangsw {
 /**
  * 스레드에 매우 안전하지 않은 클래스입니다.
  * 별도의 스레드와 사용 시 반드시 락 필요
+ *
+ * If Pow2_ is set, capacity is rounded up to power of two, and head/tail become
+ * monotonically increasing counters which are masked on access. Then every index
+ * operation is branch-free, and no sentinel slot is wasted.
+ *
+ * Storage is obtained from Alloc_, thus respects alignof(Ty_), and can be placed on
+ * any memory resource via pmr::circular_queue.
  */
-template <typename Ty_>
+template <typename Ty_, bool Pow2_ = false, typename Alloc_ = std::allocator<Ty_>>
 class circular_queue {
-    using chunk_t = std::array<int8_t, sizeof(Ty_)>;
+    using _alloc_traits = std::allocator_traits<Alloc_>;
+    static_assert(std::is_same_v<typename _alloc_traits::value_type, Ty_>);
+    static_assert(std::is_same_v<typename _alloc_traits::pointer, Ty_*>);
 
 public:
     using value_type = Ty_;
+    using allocator_type = Alloc_;
 
 public:
     template <bool Constant_ = true>
@@ -75,11 +93,35 @@ public:
     };
 
 public:
-    circular_queue(size_t capacity) noexcept :
-        _capacity(capacity + 1), _data(capacity ? std::make_unique<chunk_t[]>(_capacity) : nullptr) {}
-    circular_queue(const circular_queue& op) noexcept { *this = op; }
-    circular_queue(circular_queue&& op) noexcept = default;
-    circular_queue& operator=(circular_queue&& op) noexcept {
+    circular_queue(size_t capacity, Alloc_ const& alloc = Alloc_{}) :
+        _alloc(alloc), _capacity(_num_slots(capacity)), _data(capacity ? _alloc_traits::allocate(_alloc, _capacity) : nullptr) {}
+
+    circular_queue(const circular_queue& op) :
+        circular_queue(op.capacity(), _alloc_traits::select_on_container_copy_construction(op._alloc)) {
+        _push_spans(op.as_spans());
+    }
+
+    circular_queue(circular_queue&& op) noexcept :
+        _alloc(std::move(op._alloc)),
+        _capacity(std::exchange(op._capacity, _num_slots(0))),
+        _data(std::exchange(op._data, nullptr)),
+        _head(std::exchange(op._head, 0)),
+        _tail(std::exchange(op._tail, 0)) {}
+
+    circular_queue& operator=(circular_queue&& op) noexcept(_adopts_storage_always()) {
+        if constexpr (!_adopts_storage_always()) {
+            if (_alloc != op._alloc) {
+                // storage of op can't be freed by our allocator; move elements instead.
+                clear();
+                reserve_shrink(op.capacity());
+                auto [a, b] = op.as_spans();
+                for (auto& elem : a) { push(std::move(elem)); }
+                for (auto& elem : b) { push(std::move(elem)); }
+                return op.clear(), *this;
+            }
+        }
+
+        if constexpr (_alloc_traits::propagate_on_container_move_assignment::value) { std::swap(_alloc, op._alloc); }
         std::swap(_head, op._head);
         std::swap(_tail, op._tail);
         std::swap(_data, op._data);
@@ -87,36 +129,47 @@ public:
         return *this;
     }
 
-    circular_queue& operator=(const circular_queue& op) noexcept {
+    circular_queue& operator=(const circular_queue& op) {
+        if (this == &op) { return *this; }
         clear();
-        _head = {};
-        _tail = {};
-        _capacity = op._capacity;
-        _data = std::make_unique<chunk_t[]>(_capacity);
 
-        std::copy(op.begin(), op.end(), begin());
+        if constexpr (_alloc_traits::propagate_on_container_copy_assignment::value) {
+            if (_alloc != op._alloc) { reserve_shrink(0); }
+            _alloc = op._alloc;
+        }
+
+        reserve_shrink(op.capacity());
+        _push_spans(op.as_spans());
         return *this;
     }
 
-    void reserve_shrink(size_t new_cap) {
-        if (new_cap == capacity()) { return; }
-        if (new_cap == 0) { clear(), _data.reset(), _capacity = 1; }
-        auto n_copy = std::min(size(), new_cap);
+    ~circular_queue() {
+        clear();
+        if (_data) { _alloc_traits::deallocate(_alloc, _data, _capacity); }
+    }
 
-        // move available objects
-        circular_queue next{new_cap};
-        std::move(begin(), begin() + n_copy, std::back_inserter(next));
+    allocator_type get_allocator() const noexcept { return _alloc; }
 
-        // destroies unmoved objects
-        _tail = _jmp(_tail, n_copy);
-        clear();
+    /**
+     * Grows capacity to at least new_cap, keeping all elements.
+     * Elements are relocated as (at most) two bulk moves, or memcpy for trivially copyable types.
+     */
+    void reserve(size_t new_cap) {
+        if (new_cap > capacity()) { _relocate(new_cap); }
+    }
 
-        *this = std::move(next);
+    /**
+     * Changes capacity to new_cap. If it shrinks below size(), only front elements are kept.
+     */
+    void reserve_shrink(size_t new_cap) {
+        if (_num_slots(new_cap) == _capacity && (new_cap == 0) == (_data == nullptr)) { return; }
+        _relocate(new_cap);
     }
 
-    void push(Ty_ const& s) { new (_data[_reserve()].data()) Ty_(s); }
-    void push(Ty_&& s) { new (_data[_reserve()].data()) Ty_(std::move(s)); }
+    void push(Ty_ const& s) { _alloc_traits::construct(_alloc, _ptr(_slot(_reserve())), s); }
+    void push(Ty_&& s) { _alloc_traits::construct(_alloc, _ptr(_slot(_reserve())), std::move(s)); }
     void pop() { _release(); }
+    void pop_back() { _release_back(); }
     void push_back(Ty_ const& s) { this->push_rotate(s); }
     void push_back(Ty_&& s) { this->push_rotate(std::move(s)); }
 
@@ -131,6 +184,7 @@ public:
     }
 
     size_t size() const {
+        if constexpr (Pow2_) { return _head - _tail; }
         return _head >= _tail ? _head - _tail : _head + _cap() - _tail;
     }
 
@@ -141,15 +195,19 @@ public:
     auto begin() noexcept { return iterator<false>(this, _tail); }
     auto end() noexcept { return iterator<false>(this, _head); }
 
-    constexpr size_t capacity() const { return _capacity - 1; }
+    constexpr size_t capacity() const { return Pow2_ ? _capacity : _capacity - 1; }
     bool empty() const { return _head == _tail; }
 
     Ty_& front() { return _front(); }
     Ty_ const& front() const { return _front(); }
 
     Ty_& back() { return _back(); }
+    Ty_ const& back() const { return _back(); }
 
-    bool is_full() const { return _next(_head) == _tail; }
+    bool is_full() const {
+        if constexpr (Pow2_) { return _head - _tail == _capacity; }
+        return _next(_head) == _tail;
+    }
 
     template <class Fn_>
     void for_each(Fn_&& fn) {
@@ -161,14 +219,95 @@ public:
         for (size_t it = _tail; it != _head; it = _next(it)) { fn(static_cast<const Ty_&>(_at(it))); }
     }
 
+    /**
+     * Live elements as (at most) two contiguous spans, in order from front to back.
+     * Second span is empty unless the data wraps around the end of storage.
+     */
+    auto as_spans() noexcept { return _spans<Ty_>(); }
+    auto as_spans() const noexcept { return _spans<Ty_ const>(); }
+
+    /**
+     * Pushes [first, last) at once. Throws if there's not enough room.
+     */
+    template <std::forward_iterator It_>
+    void push_range(It_ first, It_ last) {
+        auto const n = static_cast<size_t>(std::distance(first, last));
+        if (n > capacity() - size()) throw std::bad_array_new_length();
+
+        auto const head_slot = _slot(_head);
+        auto const n_first = std::min(n, _cap() - head_slot);
+        first = _copy_in(_ptr(head_slot), first, n_first);
+        try {
+            _copy_in(_ptr(0), first, n - n_first);
+        } catch (...) {
+            _destroy_n(_ptr(head_slot), n_first);
+            throw;
+        }
+        _head = _jmp(_head, n);
+    }
+
+    template <std::ranges::forward_range Range_>
+    void push_range(Range_&& range) { push_range(std::ranges::begin(range), std::ranges::end(range)); }
+
+    /**
+     * Discards front n elements.
+     */
+    void pop_n(size_t n) {
+        assert(n <= size());
+        auto [a, b] = as_spans();
+        _destroy_n(a.data(), std::min(n, a.size()));
+        _destroy_n(b.data(), n - std::min(n, a.size()));
+        _tail = _jmp(_tail, n);
+    }
+
+    /**
+     * Moves out front n elements into dst, then pops them.
+     * @return number of popped elements
+     */
+    template <typename OutIt_>
+    size_t pop_n(OutIt_ dst, size_t n) {
+        n = std::min(n, size());
+        auto [a, b] = as_spans();
+        auto const n_first = std::min(n, a.size());
+        dst = _copy_out<true>(a.data(), n_first, dst);
+        _copy_out<true>(b.data(), n - n_first, dst);
+
+        pop_n(n);
+        return n;
+    }
+
+    /**
+     * Copies front n elements (all by default) into dst, without popping.
+     * @return output iterator past the last copied element
+     */
+    template <typename OutIt_>
+    OutIt_ copy_out(OutIt_ dst, size_t n = ~size_t{}) const {
+        n = std::min(n, size());
+        auto [a, b] = _spans<Ty_>();
+        auto const n_first = std::min(n, a.size());
+        dst = _copy_out(a.data(), n_first, dst);
+        return _copy_out(b.data(), n - n_first, dst);
+    }
+
     void clear() {
         while (!empty()) { pop(); }
     }
 
-    ~circular_queue() { clear(); }
-
 private:
+    static size_t _num_slots(size_t capacity) noexcept {
+        if constexpr (Pow2_) { return capacity ? std::bit_ceil(capacity) : 0; }
+        return capacity + 1;
+    }
+
+    static constexpr bool _adopts_storage_always() noexcept {
+        return _alloc_traits::propagate_on_container_move_assignment::value || _alloc_traits::is_always_equal::value;
+    }
+
+    // elements which the allocator would construct as a plain copy may be moved around by memcpy.
+    static constexpr bool _bitwise = std::is_trivially_copyable_v<Ty_> && !std::uses_allocator_v<Ty_, Alloc_>;
+
     size_t _cap() const noexcept { return _capacity; }
+    size_t _slot(size_t i) const noexcept { return Pow2_ ? i & (_capacity - 1) : i; }
 
     size_t _reserve() {
         if (is_full()) throw std::bad_array_new_length();
@@ -178,37 +317,140 @@ private:
     }
 
     size_t _next(size_t current) const noexcept {
+        if constexpr (Pow2_) { return current + 1; }
         return ++current == _cap() ? 0 : current;
     }
 
     size_t _prev(size_t current) const noexcept {
+        if constexpr (Pow2_) { return current - 1; }
         return --current == ~size_t{} ? _cap() - 1 : current;
     }
 
     size_t _jmp(size_t at, ptrdiff_t jmp) const noexcept {
+        if constexpr (Pow2_) { return at + jmp; }
         if (jmp >= 0) { return (at + jmp) % _cap(); }
         return at += jmp, at + _cap() * ((ptrdiff_t)at < 0);
     }
 
     size_t _idx_linear(size_t i) const noexcept {
+        if constexpr (Pow2_) { return i - _tail; }
         if (_head >= _tail) { return i; }
         return i - _tail * (i >= _tail) + (_cap() - _tail) * (i < _tail);
     }
 
     void _release() {
         assert(!empty());
-        reinterpret_cast<Ty_&>(_data[_tail]).~Ty_();
+        _alloc_traits::destroy(_alloc, &_at(_tail));
         _tail = _next(_tail);
     }
 
+    void _release_back() {
+        _alloc_traits::destroy(_alloc, &_back());
+        _head = _prev(_head);
+    }
+
     Ty_& _front() const {
         assert(!empty());
-        return reinterpret_cast<Ty_&>(const_cast<chunk_t&>(_data[_tail]));
+        return _at(_tail);
+    }
+
+    Ty_* _ptr(size_t slot) const noexcept { return _data + slot; }
+
+    void _push_spans(std::pair<std::span<Ty_ const>, std::span<Ty_ const>> spans) {
+        push_range(spans.first.begin(), spans.first.end());
+        push_range(spans.second.begin(), spans.second.end());
+    }
+
+    /**
+     * Moves front elements into newly allocated storage of new_cap, where they're laid
+     * out from slot 0. Elements which don't fit are destroyed.
+     */
+    void _relocate(size_t new_cap) {
+        auto const num_slots = _num_slots(new_cap);
+        auto const data = new_cap ? _alloc_traits::allocate(_alloc, num_slots) : nullptr;
+        auto const n_keep = std::min(size(), Pow2_ ? num_slots : new_cap);
+
+        auto [a, b] = as_spans();
+        auto const n_first = std::min(n_keep, a.size());
+
+        if constexpr (_bitwise) {
+            if (n_first) { std::memcpy(data, a.data(), n_first * sizeof(Ty_)); }
+            if (n_keep - n_first) { std::memcpy(data + n_first, b.data(), (n_keep - n_first) * sizeof(Ty_)); }
+        }
+        else {
+            size_t n_built = 0;
+            try {
+                _copy_in(data, std::make_move_iterator(a.data()), n_first), n_built = n_first;
+                _copy_in(data + n_first, std::make_move_iterator(b.data()), n_keep - n_first);
+            } catch (...) {
+                _destroy_n(data, n_built);
+                if (data) { _alloc_traits::deallocate(_alloc, data, num_slots); }
+                throw;
+            }
+        }
+
+        // moved-from objects are destroyed along with the ones which didn't fit.
+        clear();
+        if (_data) { _alloc_traits::deallocate(_alloc, _data, _capacity); }
+
+        _data = data;
+        _capacity = num_slots;
+        _tail = 0;
+        _head = n_keep;
+    }
+
+    template <typename ElemTy_>
+    std::pair<std::span<ElemTy_>, std::span<ElemTy_>> _spans() const noexcept {
+        if (empty()) { return {}; }
+        auto const n = size();
+        auto const tail_slot = _slot(_tail);
+        auto const n_first = std::min(n, _cap() - tail_slot);
+        return {{_ptr(tail_slot), n_first}, {_ptr(0), n - n_first}};
+    }
+
+    /**
+     * Constructs n elements at dst from src through the allocator. If any of them throws,
+     * ones already built are destroyed before rethrow.
+     */
+    template <typename It_>
+    It_ _copy_in(Ty_* dst, It_ src, size_t n) {
+        if constexpr (_bitwise && std::contiguous_iterator<It_> && std::is_same_v<std::iter_value_t<It_>, Ty_>) {
+            if (n) { std::memcpy(dst, std::to_address(src), n * sizeof(Ty_)); }
+            return src + n;
+        }
+        else {
+            size_t i = 0;
+            try {
+                for (; i < n; ++i, ++src) { _alloc_traits::construct(_alloc, dst + i, *src); }
+            } catch (...) {
+                _destroy_n(dst, i);
+                throw;
+            }
+            return src;
+        }
+    }
+
+    void _destroy_n(Ty_* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) { _alloc_traits::destroy(_alloc, p + i); }
+    }
+
+    template <bool Move_ = false, typename OutIt_>
+    static OutIt_ _copy_out(Ty_* src, size_t n, OutIt_ dst) {
+        if constexpr (std::is_trivially_copyable_v<Ty_> && std::is_same_v<OutIt_, Ty_*>) {
+            if (n) { std::memcpy(dst, src, n * sizeof(Ty_)); }
+            return dst + n;
+        }
+        else if constexpr (Move_) {
+            return std::move(src, src + n, dst);
+        }
+        else {
+            return std::copy_n(src, n, dst);
+        }
     }
 
     Ty_& _at(size_t i) const {
         assert(!empty());
-        return reinterpret_cast<Ty_&>(const_cast<chunk_t&>(_data[i]));
+        return _data[_slot(i)];
     }
 
     Ty_& _back() const {
@@ -217,9 +459,15 @@ private:
     }
 
 private:
+    [[no_unique_address]] Alloc_ _alloc;
     size_t _capacity;
-    std::unique_ptr<chunk_t[]> _data;
+    Ty_* _data = nullptr;
     size_t _head = {};
     size_t _tail = {};
 };
+
+namespace pmr {
+template <typename Ty_, bool Pow2_ = false>
+using circular_queue = kangsw::circular_queue<Ty_, Pow2_, std::pmr::polymorphic_allocator<Ty_>>;
+}
 } // namespace kangsw
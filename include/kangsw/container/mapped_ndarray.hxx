@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include "kangsw/container/ndarray.hxx"
+#include "kangsw/container/ndarray_view.hxx"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kangsw::inline containers {
+enum class map_mode {
+    read_only,
+    copy_on_write, // writable, but changes are private to the process and never reach the file
+};
+
+/**
+ * NumPy .npy format helpers
+ * @see https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+ */
+namespace _npy {
+inline constexpr std::string_view magic = "\x93NUMPY";
+inline constexpr size_t header_align = 64;
+
+template <typename Ty_>
+std::string descr() {
+    static_assert(std::is_arithmetic_v<Ty_>, "only arithmetic element types can be described");
+    char const order = sizeof(Ty_) == 1 ? '|' : std::endian::native == std::endian::little ? '<' : '>';
+    char const kind = std::is_same_v<Ty_, bool> ? 'b' : std::is_floating_point_v<Ty_> ? 'f' : std::is_signed_v<Ty_> ? 'i' : 'u';
+    return std::string{order, kind} + std::to_string(sizeof(Ty_));
+}
+
+struct header_t {
+    std::string descr;
+    bool fortran_order = false;
+    std::vector<size_t> shape;
+    size_t data_offset = 0;
+};
+
+inline std::string make_header(std::string_view descr, bool fortran_order, size_t const* shape, size_t num_dims) {
+    std::string dict = "{'descr': '";
+    dict.append(descr).append("', 'fortran_order': ").append(fortran_order ? "True" : "False").append(", 'shape': (");
+    for (size_t i = 0; i < num_dims; ++i) { dict.append(std::to_string(shape[i])).append(num_dims == 1 ? "," : i + 1 < num_dims ? ", " : ""); }
+    dict.append("), }");
+
+    // version 1.0 has 2-byte header length, which is enough for any sane shape.
+    auto const prefix = magic.size() + 2 + 2;
+    auto const total = (prefix + dict.size() + 1 + header_align - 1) / header_align * header_align;
+    dict.resize(total - prefix - 1, ' ');
+    dict.push_back('\n');
+
+    if (dict.size() > 0xffff) { throw std::invalid_argument("npy header too long"); }
+    std::string header{magic};
+    header.push_back(1), header.push_back(0);
+    header.push_back(char(dict.size() & 0xff)), header.push_back(char(dict.size() >> 8));
+    return header + dict;
+}
+
+inline header_t parse(char const* data, size_t size) {
+    auto fail = [] { throw std::invalid_argument("not a valid npy file"); };
+    if (size < magic.size() + 4 || std::string_view{data, magic.size()} != magic) { fail(); }
+
+    auto const u8 = [&](size_t i) { return size_t(static_cast<unsigned char>(data[i])); };
+    auto const major = u8(6);
+    size_t dict_len, dict_begin;
+    if (major == 1) { dict_len = u8(8) | u8(9) << 8, dict_begin = 10; }
+    else if ((major == 2 || major == 3) && size >= 12) { dict_len = u8(8) | u8(9) << 8 | u8(10) << 16 | u8(11) << 24, dict_begin = 12; }
+    else { fail(); }
+    if (dict_begin + dict_len > size) { fail(); }
+
+    std::string_view const dict{data + dict_begin, dict_len};
+    auto value_of = [&](std::string_view key) {
+        auto pos = dict.find(key);
+        if (pos == dict.npos || (pos = dict.find(':', pos + key.size())) == dict.npos) { fail(); }
+        return dict.substr(dict.find_first_not_of(' ', pos + 1));
+    };
+
+    header_t r;
+    r.data_offset = dict_begin + dict_len;
+
+    auto descr = value_of("'descr'");
+    auto const quote = descr.empty() ? '\'' : descr[0];
+    if (auto end = descr.find(quote, 1); end != descr.npos) { r.descr = descr.substr(1, end - 1); }
+    else { fail(); }
+
+    r.fortran_order = value_of("'fortran_order'").starts_with("True");
+
+    auto shape = value_of("'shape'");
+    if (shape.empty() || shape[0] != '(') { fail(); }
+    shape = shape.substr(1, shape.find(')') - 1);
+    for (auto p = shape.data(), end = p + shape.size(); p < end;) {
+        if (*p < '0' || *p > '9') { ++p; continue; }
+        size_t extent = 0;
+        p = std::from_chars(p, end, extent).ptr;
+        r.shape.push_back(extent);
+    }
+
+    return r;
+}
+} // namespace _npy
+
+/**
+ * Read-only, or copy-on-write ndarray which maps a NumPy .npy file into memory.
+ *
+ * Opening is O(1) regardless of file size; pages are loaded lazily on first access.
+ * Both C and Fortran ordered files are supported, as the latter only reverses strides.
+ * The file must describe exactly Ty_ in native byte order, and its data must be aligned
+ * to alignof(Ty_), which holds for any file written by NumPy or save_npy().
+ */
+template <typename Ty_, size_t Dim_ = 1>
+class mapped_ndarray {
+    static_assert(std::is_trivially_copyable_v<Ty_>);
+
+public:
+    using value_type = Ty_;
+    using size_type = size_t;
+    using dimension_type = std::array<size_type, Dim_>;
+    enum : size_t { dimension = Dim_ };
+
+public:
+    explicit mapped_ndarray(std::filesystem::path const& path, map_mode mode = map_mode::read_only) :
+        _mode(mode) {
+        _map(path);
+
+        try {
+            _bind();
+        } catch (...) {
+            _unmap();
+            throw;
+        }
+    }
+
+    mapped_ndarray(mapped_ndarray&& op) noexcept { *this = std::move(op); }
+    mapped_ndarray& operator=(mapped_ndarray&& op) noexcept {
+        std::swap(_base, op._base);
+        std::swap(_length, op._length);
+        std::swap(_mode, op._mode);
+        std::swap(_view, op._view);
+        return *this;
+    }
+
+    mapped_ndarray(mapped_ndarray const&) = delete;
+    mapped_ndarray& operator=(mapped_ndarray const&) = delete;
+
+    ~mapped_ndarray() { _unmap(); }
+
+public:
+    ndarray_view<Ty_ const, Dim_> view() const noexcept { return _view; }
+
+    /**
+     * Writable view, which is available only in copy-on-write mode.
+     */
+    ndarray_view<Ty_, Dim_> mutable_view() {
+        if (_mode != map_mode::copy_on_write) { throw std::logic_error("mapping is read-only"); }
+        return _view;
+    }
+
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    Ty_ const& operator()(Idxs_... index) const { return _view(index...); }
+
+    Ty_ const& operator[](dimension_type const& i) const { return _view[i]; }
+
+    auto dims() const noexcept { return _view.dims(); }
+    auto size() const noexcept { return _view.size(); }
+    auto mode() const noexcept { return _mode; }
+
+private:
+    void _map(std::filesystem::path const& path) {
+#ifdef _WIN32
+        auto const file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { _throw_last_error("failed to open file"); }
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            _throw_last_error("failed to stat file");
+        }
+        _length = size_t(size.QuadPart);
+        if (_length == 0) {
+            CloseHandle(file);
+            throw std::invalid_argument("not a valid npy file");
+        }
+
+        auto const cow = _mode == map_mode::copy_on_write;
+        auto const mapping = CreateFileMappingW(file, nullptr, cow ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (mapping == nullptr) { _throw_last_error("failed to map file"); }
+
+        // the view keeps mapping object alive
+        _base = MapViewOfFile(mapping, cow ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (_base == nullptr) { _throw_last_error("failed to map file"); }
+#else
+        auto const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { _throw_last_error("failed to open file"); }
+
+        struct stat st = {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            _throw_last_error("failed to stat file");
+        }
+        _length = size_t(st.st_size);
+        if (_length == 0) {
+            ::close(fd);
+            throw std::invalid_argument("not a valid npy file");
+        }
+
+        auto const cow = _mode == map_mode::copy_on_write;
+        auto const base = ::mmap(nullptr, _length, PROT_READ | (cow ? PROT_WRITE : 0), cow ? MAP_PRIVATE : MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) { _throw_last_error("failed to map file"); }
+        _base = base;
+#endif
+    }
+
+    void _unmap() noexcept {
+        if (_base == nullptr) { return; }
+#ifdef _WIN32
+        UnmapViewOfFile(_base);
+#else
+        ::munmap(_base, _length);
+#endif
+        _base = nullptr;
+    }
+
+    static void _throw_last_error(char const* what) {
+#ifdef _WIN32
+        throw std::system_error(int(GetLastError()), std::system_category(), what);
+#else
+        throw std::system_error(errno, std::generic_category(), what);
+#endif
+    }
+
+    void _bind() {
+        auto const bytes = static_cast<char*>(_base);
+        auto const header = _npy::parse(bytes, _length);
+
+        if (header.descr != _npy::descr<Ty_>()) { throw std::invalid_argument("element type mismatch: " + header.descr); }
+        if (header.shape.size() != Dim_) { throw std::invalid_argument("dimension mismatch"); }
+        if (header.data_offset % alignof(Ty_)) { throw std::invalid_argument("misaligned data"); }
+
+        dimension_type dims;
+        std::copy(header.shape.begin(), header.shape.end(), dims.begin());
+
+        // extents are untrusted; bound the product by what's left after header, so it never wraps.
+        auto const capacity = (_length - header.data_offset) / sizeof(Ty_);
+        for (size_t num_elems = 1; auto extent : dims) {
+            if (extent != 0 && num_elems > capacity / extent) { throw std::invalid_argument("truncated npy file"); }
+            num_elems *= extent;
+        }
+
+        auto const data = reinterpret_cast<Ty_*>(bytes + header.data_offset);
+        if (!header.fortran_order) { return void(_view = {data, dims}); }
+
+        // column-major; same as row-major of reversed dims, transposed.
+        std::reverse(dims.begin(), dims.end());
+        _view = ndarray_view<Ty_, Dim_>{data, dims}.transpose();
+    }
+
+private:
+    void* _base = nullptr;
+    size_t _length = 0;
+    map_mode _mode = map_mode::read_only;
+    ndarray_view<Ty_, Dim_> _view;
+};
+
+/**
+ * Writes a view as C ordered .npy file, which can be loaded by NumPy or mapped_ndarray.
+ */
+template <typename Ty_, size_t Dim_>
+void save_npy(std::filesystem::path const& path, ndarray_view<Ty_, Dim_> const& view) {
+    using value_type = std::remove_cv_t<Ty_>;
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file) { throw std::system_error(errno, std::generic_category(), "failed to open file"); }
+
+    auto const dims = view.dims();
+    file << _npy::make_header(_npy::descr<value_type>(), false, dims.data(), Dim_);
+
+    if (view.is_contiguous()) {
+        file.write(reinterpret_cast<char const*>(view.data()), std::streamsize(view.size() * sizeof(value_type)));
+    }
+    else {
+        std::vector<value_type> buffer;
+        buffer.reserve(std::min<size_t>(view.size(), 1 << 16));
+
+        auto flush = [&] {
+            file.write(reinterpret_cast<char const*>(buffer.data()), std::streamsize(buffer.size() * sizeof(value_type)));
+            buffer.clear();
+        };
+
+        view.for_each([&](value_type const& e) {
+            buffer.push_back(e);
+            if (buffer.size() == buffer.capacity()) { flush(); }
+        });
+        flush();
+    }
+
+    if (!file) { throw std::system_error(errno, std::generic_category(), "failed to write file"); }
+}
+
+template <typename Ty_, size_t Dim_, typename Layout_>
+void save_npy(std::filesystem::path const& path, ndarray<Ty_, Dim_, Layout_> const& array) {
+    save_npy(path, array.view());
+}
+} // namespace kangsw::inline containers
@@ -1,20 +1,68 @@
 #pragma once
 #include <array>
 #include <numeric>
+#include <utility>
 #include <vector>
+#include "kangsw/container/ndarray_view.hxx"
+#include "kangsw/helpers/aligned_allocator.hxx"
 #include "kangsw/helpers/zip.hxx"
 
 namespace kangsw::inline containers {
+/**
+ * Default layout of ndarray, which packs elements densely in row-major order.
+ */
+struct dense_layout {
+    template <typename Ty_>
+    using allocator_type = std::allocator<Ty_>;
+
+    static constexpr size_t row_step(size_t num_elems, size_t) noexcept { return num_elems; }
+};
+
+/**
+ * Storage aligned to Align_ bytes, and if PadRows_ is set, rows (the last dimension) are
+ * padded so that every row starts on Align_ boundary too.
+ */
+template <size_t Align_ = 64, bool PadRows_ = true>
+struct aligned_layout {
+    template <typename Ty_>
+    using allocator_type = aligned_allocator<Ty_, Align_>;
+
+    static constexpr size_t row_step(size_t num_elems, size_t elem_size) noexcept {
+        if (!PadRows_ || Align_ % elem_size) { return num_elems; }
+        auto const align_elems = Align_ / elem_size;
+        return (num_elems + align_elems - 1) / align_elems * align_elems;
+    }
+};
+
+/**
+ * Shape known at compile time. Storage is an inline std::array, thus the array never
+ * allocates, and indexing is unrolled over constexpr strides.
+ *
+ * @code
+ *   ndarray<float, 2, fixed_shape<3, 3>> rot;     // or, fixed_ndarray<float, 3, 3>
+ * @endcode
+ */
+template <size_t... Dims_>
+struct fixed_shape {
+    static_assert(sizeof...(Dims_) > 0);
+};
+
 /**
  * N-dimensional array
  * Basically, wrapper of an vector
+ *
+ * With padded layout, begin()/end() and vector() cover padding elements of each row too.
+ * Use view() or counter(dims()) to visit only the logical elements.
  */
-template <typename Ty_, size_t Dim_ = 1>
+template <typename Ty_, size_t Dim_ = 1, typename Layout_ = dense_layout>
 class ndarray {
+    using vector_type = std::vector<Ty_, typename Layout_::template allocator_type<Ty_>>;
+
 public:
-    using value_type = typename std::vector<Ty_>::value_type;
-    using reference = typename std::vector<Ty_>::reference;
-    using const_reference = typename std::vector<Ty_>::const_reference;
+    using value_type = typename vector_type::value_type;
+    using reference = typename vector_type::reference;
+    using const_reference = typename vector_type::const_reference;
+    using layout_type = Layout_;
     using size_type = size_t;
     using dimension_type = std::array<size_type, Dim_>;
     enum : size_t { dimension = Dim_ };
@@ -44,17 +92,14 @@ private:
     }
 
     auto _apply_reshape() {
-        data_.resize(std::reduce(dim_.begin(), dim_.end(), size_type(1), std::multiplies<>{}));
-
-        auto it_dim = dim_.end() - 1;
-        auto it_dim_end = dim_.begin();
-        auto it_step = steps_.end() - 1;
-
-        for (size_t step = 1;; --it_step) {
-            step *= *it_dim;
-            *it_step = step;
-
-            if (--it_dim == it_dim_end) { break; }
+        if constexpr (dimension == 1) {
+            data_.resize(dim_[0]);
+        }
+        else {
+            // padding applies only to the leading dimension, i.e. each row.
+            auto step = Layout_::row_step(dim_.back(), sizeof(Ty_));
+            for (size_t i = dimension - 1; i-- > 0;) { steps_[i] = step, step *= dim_[i]; }
+            data_.resize(step);
         }
     }
 
@@ -66,6 +111,39 @@ public:
     }
 
     ndarray() noexcept = default;
+
+    /**
+     * Evaluates a lazy expression in single pass. @see ndarray_expr.hxx
+     */
+    template <typename Expr_>
+    requires requires(Expr_ const& e, ndarray_view<Ty_, Dim_> v) { e.evaluate_to(v); }
+    ndarray(Expr_ const& expr) {
+        reshape(expr.dims());
+        expr.evaluate_to(view());
+    }
+
+    template <typename Expr_>
+    requires requires(Expr_ const& e, ndarray_view<Ty_, Dim_> v) { e.evaluate_to(v); }
+    ndarray& operator=(Expr_ const& expr) {
+        if (dim_ != expr.dims()) { reshape(expr.dims()); }
+        return expr.evaluate_to(view()), *this;
+    }
+
+    /**
+     * Copies elements of a view into a new array.
+     */
+    template <typename Other_>
+    explicit ndarray(ndarray_view<Other_, Dim_> const& view) {
+        reshape(view.dims());
+        if (dimension == 1 || is_packed()) {
+            auto it = data_.begin();
+            view.for_each([&](auto& e) { *it++ = e; });
+        }
+        else if constexpr (dimension > 1) {
+            auto dst = this->view();
+            for (auto const& idx : view.indices()) { dst[idx] = view[idx]; }
+        }
+    }
     ndarray(ndarray const&) noexcept = default;
     ndarray(ndarray&&) noexcept = default;
     ndarray& operator=(ndarray&&) noexcept = default;
@@ -124,8 +202,29 @@ public:
     auto end() { return data_.end(); }
     auto cend() const { return data_.cend(); }
 
-    auto size() const { return data_.size(); }
+    /**
+     * Number of logical elements, which excludes row padding.
+     */
+    size_type size() const {
+        if constexpr (std::is_same_v<Layout_, dense_layout>) { return data_.size(); }
+        return std::reduce(dim_.begin(), dim_.end(), size_type(1), std::multiplies<>{});
+    }
+
     auto dims() const { return dim_; }
+    auto steps() const { return steps_; }
+
+    /**
+     * Distance between starts of consecutive rows, in elements.
+     */
+    size_type pitch() const {
+        if constexpr (dimension == 1) { return dim_[0]; }
+        else { return steps_.back(); }
+    }
+
+    bool is_packed() const { return data_.size() == size(); }
+
+    ndarray_view<Ty_, Dim_> view() { return {data_.data(), dim_, _strides()}; }
+    ndarray_view<Ty_ const, Dim_> view() const { return {data_.data(), dim_, _strides()}; }
     auto shrink_to_fit() { data_.shrink_to_fit(); }
 
     auto data() const { return data_.data(); }
@@ -137,7 +236,10 @@ public:
     template <typename It_>
     void assign(It_ first, It_ last) {
         if (std::distance(first, last) != size()) { throw std::logic_error{"Assignment size mismatch"}; }
-        data_.assign(first, last);
+        if (dimension == 1 || is_packed()) { return data_.assign(first, last); }
+        if constexpr (dimension > 1) {
+            for (auto const& idx : counter(dim_)) { (*this)[idx] = *first++; }
+        }
     }
 
     void assign(std::initializer_list<value_type> values) { assign(values.begin(), values.end()); }
@@ -145,10 +247,144 @@ public:
     bool operator==(ndarray const& r) const { return dim_ == r.dim_ && data_ == r.data_; }
     bool operator!=(ndarray const& r) const { return !(*this == r); }
 
+private:
+    dimension_type _strides() const {
+        dimension_type strides;
+        std::copy(steps_.begin(), steps_.end(), strides.begin());
+        return strides.back() = 1, strides;
+    }
+
 private:
     dimension_type dim_;
     std::array<size_type, dimension - 1> steps_;
-    std::vector<Ty_> data_;
+    vector_type data_;
 }; // namespace kangsw::inline containers
 
+/**
+ * N-dimensional array of fixed shape, which lives wherever it is declared.
+ *
+ * Interface follows ndarray, except that it can't be reshaped, and begin()/end() iterate
+ * the inline std::array.
+ */
+template <typename Ty_, size_t Dim_, size_t... Dims_>
+class ndarray<Ty_, Dim_, fixed_shape<Dims_...>> {
+    static_assert(Dim_ == sizeof...(Dims_), "dimension does not match fixed shape");
+
+public:
+    using value_type = Ty_;
+    using reference = Ty_&;
+    using const_reference = Ty_ const&;
+    using layout_type = fixed_shape<Dims_...>;
+    using size_type = size_t;
+    using dimension_type = std::array<size_type, Dim_>;
+    enum : size_t { dimension = Dim_ };
+
+private:
+    static constexpr dimension_type _dims = {Dims_...};
+    static constexpr size_type _size = (Dims_ * ...);
+    static constexpr dimension_type _strides = [] {
+        dimension_type r = {};
+        for (size_t i = Dim_, step = 1; i-- > 0; step *= _dims[i]) { r[i] = step; }
+        return r;
+    }();
+
+    template <bool Check_, size_t... I_>
+    static constexpr size_type _reduce_index(dimension_type const& idx, std::index_sequence<I_...>) {
+        if constexpr (Check_) {
+            if (((idx[I_] >= _dims[I_]) || ...)) { throw std::invalid_argument("array index out of range"); }
+        }
+        return ((idx[I_] * _strides[I_]) + ...);
+    }
+
+    template <bool Check_ = false>
+    static constexpr size_type _index(dimension_type const& idx) {
+        return _reduce_index<Check_>(idx, std::make_index_sequence<Dim_>{});
+    }
+
+public:
+    constexpr ndarray() noexcept = default;
+
+    /**
+     * Elements in row-major order; count must match the shape.
+     */
+    constexpr ndarray(std::initializer_list<value_type> values) { assign(values); }
+
+    template <typename Expr_>
+    requires requires(Expr_ const& e, ndarray_view<Ty_, Dim_> v) { e.evaluate_to(v); }
+    ndarray(Expr_ const& expr) { *this = expr; }
+
+    template <typename Expr_>
+    requires requires(Expr_ const& e, ndarray_view<Ty_, Dim_> v) { e.evaluate_to(v); }
+    ndarray& operator=(Expr_ const& expr) {
+        if (expr.dims() != _dims) { throw std::invalid_argument("shape mismatch"); }
+        return expr.evaluate_to(view()), *this;
+    }
+
+    template <typename Other_>
+    explicit ndarray(ndarray_view<Other_, Dim_> const& view) {
+        if (view.dims() != _dims) { throw std::invalid_argument("shape mismatch"); }
+        auto it = data_.begin();
+        view.for_each([&](auto& e) { *it++ = e; });
+    }
+
+public:
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    constexpr reference operator()(Idxs_... index) { return data_[_index({size_type(index)...})]; }
+
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    constexpr const_reference operator()(Idxs_... index) const { return data_[_index({size_type(index)...})]; }
+
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    constexpr reference at(Idxs_... index) { return data_[_index<true>({size_type(index)...})]; }
+
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    constexpr const_reference at(Idxs_... index) const { return data_[_index<true>({size_type(index)...})]; }
+
+    constexpr const_reference at(dimension_type const& i) const { return data_[_index<true>(i)]; }
+    constexpr reference at(dimension_type const& i) { return data_[_index<true>(i)]; }
+    constexpr const_reference operator[](dimension_type const& i) const { return data_[_index(i)]; }
+    constexpr reference operator[](dimension_type const& i) { return data_[_index(i)]; }
+
+    constexpr auto begin() { return data_.begin(); }
+    constexpr auto cbegin() const { return data_.cbegin(); }
+    constexpr auto end() { return data_.end(); }
+    constexpr auto cend() const { return data_.cend(); }
+
+    static constexpr size_type size() noexcept { return _size; }
+    static constexpr dimension_type dims() noexcept { return _dims; }
+    static constexpr auto steps() noexcept {
+        std::array<size_type, dimension - 1> r;
+        std::copy_n(_strides.begin(), dimension - 1, r.begin());
+        return r;
+    }
+    static constexpr size_type pitch() noexcept { return _dims.back(); }
+    static constexpr bool is_packed() noexcept { return true; }
+
+    ndarray_view<Ty_, Dim_> view() { return {data_.data(), _dims, _strides}; }
+    ndarray_view<Ty_ const, Dim_> view() const { return {data_.data(), _dims, _strides}; }
+
+    constexpr auto data() const { return data_.data(); }
+    constexpr auto data() { return data_.data(); }
+
+    template <typename It_>
+    constexpr void assign(It_ first, It_ last) {
+        if (size_type(std::distance(first, last)) != _size) { throw std::logic_error{"Assignment size mismatch"}; }
+        std::copy(first, last, data_.begin());
+    }
+
+    constexpr void assign(std::initializer_list<value_type> values) { assign(values.begin(), values.end()); }
+
+    constexpr bool operator==(ndarray const& r) const { return data_ == r.data_; }
+    constexpr bool operator!=(ndarray const& r) const { return !(*this == r); }
+
+private:
+    std::array<Ty_, _size> data_ = {};
+};
+
+template <typename Ty_, size_t... Dims_>
+using fixed_ndarray = ndarray<Ty_, sizeof...(Dims_), fixed_shape<Dims_...>>;
 } // namespace kangsw::inline containers
@@ -0,0 +1,295 @@
+#pragma once
+#include <execution>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include "kangsw/container/ndarray.hxx"
+#include "kangsw/container/ndarray_ops.hxx"
+
+/**
+ * Lazy elementwise arithmetic over ndarray and ndarray_view.
+ *
+ * Operators build an ndexpr tree instead of computing anything; elements are evaluated
+ * only when the expression is assigned to an ndarray, or reduced by ops::sum and ops::min,
+ * in a single pass without any intermediate array.
+ *
+ * @code
+ *   ndarray<float, 2> a = b * c + d;         // one fused pass
+ *   auto total = ops::sum(b * c - d);        // nothing is materialized
+ * @endcode
+ *
+ * Expressions refer to their operands without copying them, thus every operand must
+ * outlive the expression. Assigning into an array which is also read through a different
+ * view (e.g. its transpose) in the same expression is undefined.
+ */
+namespace kangsw::inline containers {
+template <typename Op_, typename... Args_>
+class ndexpr;
+
+template <typename Ty_>
+constexpr bool _is_ndexpr_v = false;
+
+template <typename Op_, typename... Args_>
+constexpr bool _is_ndexpr_v<ndexpr<Op_, Args_...>> = true;
+
+template <typename Ty_>
+constexpr bool _is_nd_operand_v = _is_ndexpr_v<Ty_> || ops::_is_view_v<Ty_>;
+
+template <typename Ty_, size_t Dim_, typename Layout_>
+constexpr bool _is_nd_operand_v<ndarray<Ty_, Dim_, Layout_>> = true;
+
+/**
+ * Row of a leaf, bound for evaluation
+ */
+template <typename Ty_>
+struct _bound_leaf {
+    template <typename Value_>
+    static constexpr bool loadable = std::is_same_v<Ty_, Value_>;
+
+    ops::_row<Ty_ const> row;
+
+    bool contiguous() const noexcept { return row.stride <= 1; }
+    Ty_ at(size_t i) const { return row[i]; }
+
+#if KANGSW_NDARRAY_USE_SIMD
+    template <typename Simd_>
+    Simd_ load(size_t i) const { return ops::_load<Simd_>(row, i); }
+#endif
+};
+
+template <typename Op_, typename... Bound_>
+struct _bound_node {
+    template <typename Value_>
+    static constexpr bool loadable = (Bound_::template loadable<Value_> && ...);
+
+    Op_ op;
+    std::tuple<Bound_...> args;
+
+    bool contiguous() const noexcept {
+        return std::apply([](auto const&... a) { return (a.contiguous() && ...); }, args);
+    }
+
+    auto at(size_t i) const {
+        return std::apply([&](auto const&... a) { return op(a.at(i)...); }, args);
+    }
+
+#if KANGSW_NDARRAY_USE_SIMD
+    template <typename Simd_>
+    Simd_ load(size_t i) const {
+        return std::apply([&](auto const&... a) { return Simd_(op(a.template load<Simd_>(i)...)); }, args);
+    }
+#endif
+};
+
+template <typename Ty_>
+struct _nd_scalar {
+    using value_type = Ty_;
+    Ty_ value;
+
+    _bound_leaf<Ty_> _bind(size_t) const { return {{&value, 0}}; }
+};
+
+template <typename Ty_, size_t Dim_>
+struct _nd_leaf {
+    using value_type = std::remove_cv_t<Ty_>;
+    enum : size_t { dimension = Dim_ };
+    ndarray_view<Ty_ const, Dim_> view;
+
+    auto dims() const { return view.dims(); }
+    _bound_leaf<value_type> _bind(size_t r) const { return {ops::_row_of(view, r)}; }
+};
+
+template <typename Ty_>
+struct _nd_operand_value {
+    using type = typename Ty_::value_type;
+};
+
+template <typename Value_, typename Ty_>
+auto _as_nd_arg(Ty_ const& x) {
+    if constexpr (_is_ndexpr_v<Ty_>) { return x; }
+    else if constexpr (ops::_is_view_v<Ty_>) { return _nd_leaf<typename Ty_::element_type, Ty_::dimension>{x}; }
+    else if constexpr (_is_nd_operand_v<Ty_>) { return _nd_leaf<typename Ty_::value_type, Ty_::dimension>{x.view()}; }
+    else { return _nd_scalar<Value_>{static_cast<Value_>(x)}; }
+}
+
+template <typename Op_, typename... Args_>
+auto _make_ndexpr(Op_ op, Args_ const&... args) {
+    // scalars take value type of the first array operand
+    using value_type = typename std::conditional_t<
+      _is_nd_operand_v<std::tuple_element_t<0, std::tuple<Args_...>>>,
+      _nd_operand_value<std::tuple_element_t<0, std::tuple<Args_...>>>,
+      _nd_operand_value<std::tuple_element_t<sizeof...(Args_) - 1, std::tuple<Args_...>>>>::type;
+
+    return ndexpr<Op_, decltype(_as_nd_arg<value_type>(args))...>{op, _as_nd_arg<value_type>(args)...};
+}
+
+template <typename Arg_>
+constexpr bool _has_nd_dims = requires(Arg_ const& a) { a.dims(); };
+
+// the first operand which has dimensions
+template <typename Arg_, typename... Rest_>
+auto const& _first_nd(Arg_ const& arg, Rest_ const&... rest) {
+    if constexpr (_has_nd_dims<Arg_>) { return arg; }
+    else { return _first_nd(rest...); }
+}
+
+/**
+ * Elementwise expression over array operands and scalars.
+ */
+template <typename Op_, typename... Args_>
+class ndexpr {
+public:
+    using value_type = std::remove_cvref_t<std::invoke_result_t<Op_, typename Args_::value_type...>>;
+    enum : size_t { dimension = std::remove_cvref_t<decltype(_first_nd(std::declval<Args_>()...))>::dimension };
+    using dimension_type = std::array<size_t, dimension>;
+
+public:
+    ndexpr(Op_ op, Args_ const&... args) :
+        _op(op), _args(args...) {
+        auto const d = dims();
+        auto check = [&]<typename Arg_>(Arg_ const& arg) {
+            if constexpr (_has_nd_dims<Arg_>) {
+                if (arg.dims() != d) { throw std::invalid_argument("shape mismatch"); }
+            }
+        };
+        (check(args), ...);
+    }
+
+public:
+    dimension_type dims() const {
+        return std::apply([](auto const&... a) { return _first_nd(a...).dims(); }, _args);
+    }
+
+    size_t size() const {
+        auto const d = dims();
+        return std::reduce(d.begin(), d.end(), size_t(1), std::multiplies<>{});
+    }
+
+    /**
+     * Evaluates every element into dst, row by row.
+     */
+    template <typename DstTy_, typename ExPo_ = std::execution::sequenced_policy const&>
+    void evaluate_to(ndarray_view<DstTy_, dimension> dst, ExPo_&& policy = std::execution::seq) const {
+        if (dst.dims() != dims()) { throw std::invalid_argument("shape mismatch"); }
+
+        auto const n = dst.dims().back();
+        ops::_for_each_row(policy, ops::_num_rows(dst), [&](size_t r) {
+            auto const ev = _bind(r);
+            auto const d = ops::_row_of(dst, r);
+            size_t i = 0;
+
+#if KANGSW_NDARRAY_USE_SIMD
+            using elem_type = std::remove_cv_t<DstTy_>;
+            if constexpr (ops::_simd_able_v<elem_type> && decltype(ev)::template loadable<elem_type>) {
+                using simd_type = ops::_stdx::native_simd<elem_type>;
+                if (d.stride == 1 && ev.contiguous()) {
+                    for (; i + simd_type::size() <= n; i += simd_type::size()) {
+                        ev.template load<simd_type>(i).copy_to(d.ptr + i, ops::_stdx::element_aligned);
+                    }
+                }
+            }
+#endif
+
+            for (; i < n; ++i) { d[i] = ev.at(i); }
+        });
+    }
+
+    auto _bind(size_t r) const {
+        return std::apply([&](auto const&... a) { return _bound_node<Op_, decltype(a._bind(r))...>{_op, {a._bind(r)...}}; }, _args);
+    }
+
+private:
+    Op_ _op;
+    std::tuple<Args_...> _args;
+};
+
+struct _nd_plus {
+    auto operator()(auto const& a, auto const& b) const { return a + b; }
+};
+
+struct _nd_minus {
+    auto operator()(auto const& a, auto const& b) const { return a - b; }
+};
+
+struct _nd_multiplies {
+    auto operator()(auto const& a, auto const& b) const { return a * b; }
+};
+
+struct _nd_divides {
+    auto operator()(auto const& a, auto const& b) const { return a / b; }
+};
+
+struct _nd_negate {
+    auto operator()(auto const& a) const { return -a; }
+};
+
+template <typename L_, typename R_>
+concept _nd_binary_operands = (_is_nd_operand_v<L_> || _is_nd_operand_v<R_>)
+                              && (_is_nd_operand_v<L_> || std::is_arithmetic_v<L_>)
+                              && (_is_nd_operand_v<R_> || std::is_arithmetic_v<R_>);
+
+template <typename L_, typename R_>
+requires _nd_binary_operands<L_, R_>
+auto operator+(L_ const& l, R_ const& r) { return _make_ndexpr(_nd_plus{}, l, r); }
+
+template <typename L_, typename R_>
+requires _nd_binary_operands<L_, R_>
+auto operator-(L_ const& l, R_ const& r) { return _make_ndexpr(_nd_minus{}, l, r); }
+
+template <typename L_, typename R_>
+requires _nd_binary_operands<L_, R_>
+auto operator*(L_ const& l, R_ const& r) { return _make_ndexpr(_nd_multiplies{}, l, r); }
+
+template <typename L_, typename R_>
+requires _nd_binary_operands<L_, R_>
+auto operator/(L_ const& l, R_ const& r) { return _make_ndexpr(_nd_divides{}, l, r); }
+
+template <typename Ty_>
+requires _is_nd_operand_v<Ty_>
+auto operator-(Ty_ const& x) { return _make_ndexpr(_nd_negate{}, x); }
+} // namespace kangsw::inline containers
+
+namespace kangsw::inline containers::ops {
+/**
+ * Reduces an expression row by row, without materializing it.
+ */
+template <typename ExPo_, typename Expr_, typename Op_>
+requires _is_ndexpr_v<Expr_>
+auto _reduce_all(ExPo_&& policy, Expr_ const& src, typename Expr_::value_type init, Op_ const& op) {
+    using value_type = typename Expr_::value_type;
+    auto const n = src.dims().back();
+    std::vector<value_type> partials(n ? src.size() / n : 0, init);
+
+    _for_each_row(policy, partials.size(), [&](size_t r) {
+        auto const ev = src._bind(r);
+        auto acc = init;
+        size_t i = 0;
+
+#if KANGSW_NDARRAY_USE_SIMD
+        if constexpr (_simd_able_v<value_type> && decltype(ev)::template loadable<value_type>) {
+            using simd_type = _stdx::native_simd<value_type>;
+            if (ev.contiguous() && n >= simd_type::size()) {
+                auto vacc = ev.template load<simd_type>(0);
+                for (i = simd_type::size(); i + simd_type::size() <= n; i += simd_type::size()) {
+                    vacc = op(vacc, ev.template load<simd_type>(i));
+                }
+                acc = op(acc, _stdx::reduce(vacc, op));
+            }
+        }
+#endif
+
+        for (; i < n; ++i) { acc = op(acc, static_cast<value_type>(ev.at(i))); }
+        partials[r] = acc;
+    });
+
+    return _reduce_row<value_type>({partials.data(), 1}, partials.size(), init, op);
+}
+
+/**
+ * dst = expr, optionally in parallel
+ */
+template <typename... Args_>
+void evaluate(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& expr) { expr.evaluate_to(dst, policy); }, std::forward<Args_>(args)...);
+}
+} // namespace kangsw::inline containers::ops
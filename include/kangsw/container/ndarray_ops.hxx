@@ -0,0 +1,480 @@
+#pragma once
+#include <algorithm>
+#include <execution>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "kangsw/container/ndarray.hxx"
+#include "kangsw/helpers/counter.hxx"
+
+#ifndef KANGSW_NDARRAY_USE_SIMD
+#if __has_include(<experimental/simd>)
+#define KANGSW_NDARRAY_USE_SIMD 1
+#else
+#define KANGSW_NDARRAY_USE_SIMD 0
+#endif
+#endif
+
+#if KANGSW_NDARRAY_USE_SIMD
+#include <experimental/simd>
+#endif
+
+/**
+ * Elementwise and reduction kernels over ndarray and ndarray_view.
+ *
+ * Every kernel accepts either ndarray or ndarray_view as operand, and elementwise
+ * kernels accept scalars too, which are broadcast. An execution policy can be given as the
+ * first argument, to process rows in parallel.
+ *
+ * Kernels work row by row (the last dimension); rows with unit stride are processed with
+ * std::experimental::simd if available, and the others fall back to scalar loops.
+ *
+ * @code
+ *   ops::fma(std::execution::par, dst, a, 0.5f, b);  // dst = a * 0.5 + b
+ *   ops::min_axis(col_mins, costs, 0);
+ * @endcode
+ */
+namespace kangsw::inline containers::ops {
+template <typename Ty_>
+Ty_ _min_of(Ty_ a, Ty_ b) { return b < a ? b : a; }
+
+template <typename Ty_>
+Ty_ _max_of(Ty_ a, Ty_ b) { return a < b ? b : a; }
+
+#if KANGSW_NDARRAY_USE_SIMD
+namespace _stdx = std::experimental;
+
+template <typename Ty_>
+constexpr bool _simd_able_v = std::is_arithmetic_v<Ty_> && !std::is_same_v<Ty_, bool>;
+
+template <typename Ty_, typename Abi_>
+auto _min_of(_stdx::simd<Ty_, Abi_> const& a, _stdx::simd<Ty_, Abi_> const& b) { return _stdx::min(a, b); }
+
+template <typename Ty_, typename Abi_>
+auto _max_of(_stdx::simd<Ty_, Abi_> const& a, _stdx::simd<Ty_, Abi_> const& b) { return _stdx::max(a, b); }
+#endif
+
+template <typename Ty_>
+constexpr bool _is_view_v = false;
+
+template <typename Ty_, size_t Dim_>
+constexpr bool _is_view_v<ndarray_view<Ty_, Dim_>> = true;
+
+/**
+ * A row of operand; stride 0 repeats single element. (scalar, or broadcast view)
+ */
+template <typename Ty_>
+struct _row {
+    _row(Ty_* ptr, size_t stride) noexcept :
+        ptr(ptr), stride(stride) {}
+
+    template <typename Other_>
+    requires std::is_convertible_v<Other_*, Ty_*>
+    _row(_row<Other_> const& other) noexcept :
+        ptr(other.ptr), stride(other.stride) {}
+
+    Ty_* ptr;
+    size_t stride;
+
+    Ty_& operator[](size_t i) const { return ptr[i * stride]; }
+};
+
+template <typename Ty_>
+decltype(auto) _to_view(Ty_&& x) {
+    if constexpr (requires { x.view(); }) { return x.view(); }
+    else { return std::forward<Ty_>(x); }
+}
+
+template <typename Fn_, typename First_, typename... Args_>
+decltype(auto) _dispatch(Fn_&& fn, First_&& first, Args_&&... args) {
+    if constexpr (std::is_execution_policy_v<std::remove_cvref_t<First_>>) {
+        return fn(first, _to_view(std::forward<Args_>(args))...);
+    }
+    else {
+        return fn(std::execution::seq, _to_view(std::forward<First_>(first)), _to_view(std::forward<Args_>(args))...);
+    }
+}
+
+template <typename Ty_, size_t Dim_>
+size_t _num_rows(ndarray_view<Ty_, Dim_> const& v) {
+    auto dims = v.dims();
+    return dims.back() ? v.size() / dims.back() : 0;
+}
+
+template <typename Ty_, size_t Dim_>
+_row<Ty_> _row_of(ndarray_view<Ty_, Dim_> const& v, size_t r) {
+    auto const dims = v.dims();
+    auto const strides = v.strides();
+    auto ptr = v.data();
+    for (size_t i = Dim_ - 1; i-- > 0; r /= dims[i]) { ptr += r % dims[i] * strides[i]; }
+    return {ptr, strides.back()};
+}
+
+template <typename Ty_>
+_row<Ty_ const> _row_of(Ty_ const& scalar, size_t) { return {&scalar, 0}; }
+
+template <typename Ty_, size_t Dim_>
+Ty_& _element_at(ndarray_view<Ty_, Dim_> const& v, size_t linear) {
+    auto const row = _row_of(v, linear / v.dims().back());
+    return row[linear % v.dims().back()];
+}
+
+template <typename ExPo_, typename Fn_>
+void _for_each_row(ExPo_&& policy, size_t num_rows, Fn_&& fn) {
+    iota rows(num_rows);
+    std::for_each(policy, rows.begin(), rows.end(), fn);
+}
+
+template <typename View_, typename Operand_>
+void _check_shape(View_ const& dst, Operand_ const& src) {
+    if constexpr (_is_view_v<Operand_>) {
+        if (dst.dims() != src.dims()) { throw std::invalid_argument("shape mismatch"); }
+    }
+}
+
+// value type of the first view operand, to which scalar operands are converted.
+template <typename Dst_, typename... Srcs_>
+struct _operand_value {
+    using type = typename Dst_::value_type;
+};
+
+template <typename Dst_, typename Src_, typename... Srcs_>
+struct _operand_value<Dst_, Src_, Srcs_...> {
+    using type = typename std::conditional_t<_is_view_v<Src_>, _operand_value<Src_>, _operand_value<Dst_, Srcs_...>>::type;
+};
+
+template <typename Value_, typename Operand_>
+auto _operand(Operand_ const& x) {
+    if constexpr (_is_view_v<Operand_>) { return x; }
+    else { return static_cast<Value_>(x); }
+}
+
+template <typename, typename Ty_>
+using _repeat_t = Ty_;
+
+#if KANGSW_NDARRAY_USE_SIMD
+template <typename Simd_, typename Ty_>
+Simd_ _load(_row<Ty_> const& row, size_t i) {
+    return row.stride ? Simd_(row.ptr + i, _stdx::element_aligned) : Simd_(*row.ptr);
+}
+#endif
+
+template <typename Op_, typename DstTy_, typename... SrcTy_>
+void _transform_row(Op_ const& op, size_t n, _row<DstTy_> dst, _row<SrcTy_>... srcs) {
+    size_t i = 0;
+
+#if KANGSW_NDARRAY_USE_SIMD
+    using value_type = std::remove_cv_t<DstTy_>;
+    if constexpr (_simd_able_v<value_type> && (std::is_same_v<std::remove_cv_t<SrcTy_>, value_type> && ...)) {
+        using simd_type = _stdx::native_simd<value_type>;
+        if constexpr (std::is_invocable_r_v<simd_type, Op_ const&, _repeat_t<SrcTy_, simd_type>...>) {
+            if (dst.stride == 1 && ((srcs.stride <= 1) && ...)) {
+                for (; i + simd_type::size() <= n; i += simd_type::size()) {
+                    simd_type r = op(_load<simd_type>(srcs, i)...);
+                    r.copy_to(dst.ptr + i, _stdx::element_aligned);
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i) { dst[i] = op(srcs[i]...); }
+}
+
+template <typename ExPo_, typename Op_, typename DstTy_, size_t Dim_, typename... Srcs_>
+void _transform(ExPo_&& policy, Op_ const& op, ndarray_view<DstTy_, Dim_> dst, Srcs_ const&... srcs) {
+    (_check_shape(dst, srcs), ...);
+
+    using value_type = typename _operand_value<ndarray_view<DstTy_, Dim_>, Srcs_...>::type;
+    auto const operands = std::make_tuple(_operand<value_type>(srcs)...);
+    auto const n = dst.dims().back();
+
+    _for_each_row(policy, _num_rows(dst), [&](size_t r) {
+        std::apply([&](auto const&... o) { _transform_row(op, n, _row_of(dst, r), _row_of(o, r)...); }, operands);
+    });
+}
+
+struct _plus {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b) const { return a + b; }
+};
+
+struct _minus {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b) const { return a - b; }
+};
+
+struct _multiplies {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b) const { return a * b; }
+};
+
+struct _fma {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b, Ty_ c) const { return a * b + c; }
+};
+
+struct _minimum {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b) const { return _min_of(a, b); }
+
+    template <typename Ty_>
+    static constexpr Ty_ identity = std::numeric_limits<Ty_>::has_infinity ? std::numeric_limits<Ty_>::infinity() : std::numeric_limits<Ty_>::max();
+};
+
+struct _maximum {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a, Ty_ b) const { return _max_of(a, b); }
+};
+
+struct _identity {
+    template <typename Ty_>
+    Ty_ operator()(Ty_ a) const { return a; }
+};
+
+template <typename Ty_, typename Op_>
+Ty_ _reduce_row(_row<Ty_ const> row, size_t n, Ty_ init, Op_ const& op) {
+    size_t i = 0;
+
+#if KANGSW_NDARRAY_USE_SIMD
+    if constexpr (_simd_able_v<Ty_>) {
+        using simd_type = _stdx::native_simd<Ty_>;
+        if (row.stride == 1 && n >= simd_type::size()) {
+            simd_type acc(row.ptr, _stdx::element_aligned);
+            for (i = simd_type::size(); i + simd_type::size() <= n; i += simd_type::size()) {
+                acc = op(acc, simd_type(row.ptr + i, _stdx::element_aligned));
+            }
+            init = op(init, _stdx::reduce(acc, op));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) { init = op(init, row[i]); }
+    return init;
+}
+
+// index of the first minimum in the row; two passes, but both vectorize.
+template <typename Ty_>
+std::pair<Ty_, size_t> _argmin_row(_row<Ty_ const> row, size_t n) {
+    auto const value = _reduce_row(row, n, _minimum::identity<Ty_>, _minimum{});
+    size_t i = 0;
+    while (i < n && !(row[i] == value)) { ++i; }
+    return {value, std::min(i, n - 1)};
+}
+
+template <typename ExPo_, typename Ty_, size_t Dim_, typename Op_>
+auto _reduce_all(ExPo_&& policy, ndarray_view<Ty_, Dim_> const& src, std::remove_cv_t<Ty_> init, Op_ const& op) {
+    using value_type = std::remove_cv_t<Ty_>;
+    auto const n = src.dims().back();
+    std::vector<value_type> partials(_num_rows(src), init);
+    _for_each_row(policy, partials.size(), [&](size_t r) { partials[r] = _reduce_row<value_type>(_row_of(src, r), n, init, op); });
+    return _reduce_row<value_type>({partials.data(), 1}, partials.size(), init, op);
+}
+
+template <typename ExPo_, typename DstTy_, typename SrcTy_, size_t Dim_, typename Op_>
+void _reduce_axis(ExPo_&& policy, ndarray_view<DstTy_, Dim_ - 1> dst, ndarray_view<SrcTy_, Dim_> const& src, size_t axis, std::remove_cv_t<SrcTy_> init, Op_ const& op) {
+    if (axis >= Dim_) { throw std::invalid_argument("axis out of range"); }
+    auto const dims = src.dims(), dst_dims = dst.dims();
+    if (!std::equal(dims.begin(), dims.begin() + axis, dst_dims.begin())
+        || !std::equal(dims.begin() + axis + 1, dims.end(), dst_dims.begin() + axis)) {
+        throw std::invalid_argument("shape mismatch");
+    }
+
+    if (axis == Dim_ - 1) {
+        // horizontal; each row reduces into single element
+        auto const n = src.dims().back();
+        _for_each_row(policy, _num_rows(src), [&](size_t r) { _element_at(dst, r) = _reduce_row<std::remove_cv_t<SrcTy_>>(_row_of(src, r), n, init, op); });
+        return;
+    }
+
+    // vertical; accumulate slices elementwise, where rows stay contiguous
+    _transform(policy, _identity{}, dst, init);
+    for (size_t k = 0; k < src.dims()[axis]; ++k) { _transform(policy, op, dst, dst, src.slice(axis, k)); }
+}
+
+/**
+ * dst = value
+ */
+template <typename... Args_>
+void fill(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& value) { _transform(policy, _identity{}, dst, value); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = a + b
+ */
+template <typename... Args_>
+void add(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b) { _transform(policy, _plus{}, dst, a, b); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = a - b
+ */
+template <typename... Args_>
+void sub(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b) { _transform(policy, _minus{}, dst, a, b); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = a * b
+ */
+template <typename... Args_>
+void mul(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b) { _transform(policy, _multiplies{}, dst, a, b); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = a * b + c
+ */
+template <typename... Args_>
+void fma(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b, auto const& c) { _transform(policy, _fma{}, dst, a, b, c); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = min(a, b), elementwise
+ */
+template <typename... Args_>
+void minimum(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b) { _transform(policy, _minimum{}, dst, a, b); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * dst = max(a, b), elementwise
+ */
+template <typename... Args_>
+void maximum(Args_&&... args) {
+    _dispatch([](auto&& policy, auto dst, auto const& a, auto const& b) { _transform(policy, _maximum{}, dst, a, b); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * mask = cmp(a, b), elementwise. e.g. compare(mask, a, 0, std::less<>{})
+ */
+template <typename... Args_>
+void compare(Args_&&... args) {
+    _dispatch(
+      [](auto&& policy, auto mask, auto const& a, auto const& b, auto cmp) {
+          using value_type = typename _operand_value<decltype(mask), std::remove_cvref_t<decltype(a)>, std::remove_cvref_t<decltype(b)>>::type;
+          _transform(policy, [&cmp](value_type x, value_type y) -> bool { return cmp(x, y); }, mask, a, b);
+      },
+      std::forward<Args_>(args)...);
+}
+
+/**
+ * Sum of every element
+ */
+template <typename... Args_>
+auto sum(Args_&&... args) {
+    return _dispatch([](auto&& policy, auto const& src) { return _reduce_all(policy, src, {}, _plus{}); }, std::forward<Args_>(args)...);
+}
+
+/**
+ * Minimum of every element
+ */
+template <typename... Args_>
+auto min(Args_&&... args) {
+    return _dispatch(
+      [](auto&& policy, auto const& src) {
+          using value_type = typename std::remove_cvref_t<decltype(src)>::value_type;
+          return _reduce_all(policy, src, _minimum::identity<value_type>, _minimum{});
+      },
+      std::forward<Args_>(args)...);
+}
+
+/**
+ * Index of the first minimum element. Source must not be empty.
+ */
+template <typename... Args_>
+auto argmin(Args_&&... args) {
+    return _dispatch(
+      [](auto&& policy, auto const& src) {
+          using view_type = std::remove_cvref_t<decltype(src)>;
+          using value_type = typename view_type::value_type;
+          if (src.empty()) { throw std::invalid_argument("empty array"); }
+
+          auto const n = src.dims().back();
+          std::vector<std::pair<value_type, size_t>> partials(_num_rows(src));
+          _for_each_row(policy, partials.size(), [&](size_t r) { partials[r] = _argmin_row<value_type>(_row_of(src, r), n); });
+
+          auto best = std::min_element(partials.begin(), partials.end(), [](auto& a, auto& b) { return a.first < b.first; });
+          auto linear = (best - partials.begin()) * n + best->second;
+
+          typename view_type::dimension_type index;
+          auto const dims = src.dims();
+          for (size_t i = view_type::dimension; i-- > 0; linear /= dims[i]) { index[i] = linear % dims[i]; }
+          return index;
+      },
+      std::forward<Args_>(args)...);
+}
+
+/**
+ * Sums along given axis, into dst which has every dimension of src except the axis.
+ */
+template <typename... Args_>
+void sum_axis(Args_&&... args) {
+    _dispatch(
+      [](auto&& policy, auto dst, auto const& src, size_t axis) {
+          _reduce_axis(policy, dst, src, axis, {}, _plus{});
+      },
+      std::forward<Args_>(args)...);
+}
+
+/**
+ * Minimums along given axis, into dst which has every dimension of src except the axis.
+ */
+template <typename... Args_>
+void min_axis(Args_&&... args) {
+    _dispatch(
+      [](auto&& policy, auto dst, auto const& src, size_t axis) {
+          using value_type = typename std::remove_cvref_t<decltype(src)>::value_type;
+          _reduce_axis(policy, dst, src, axis, _minimum::identity<value_type>, _minimum{});
+      },
+      std::forward<Args_>(args)...);
+}
+
+/**
+ * Indexes of the first minimum along given axis, into dst which has every dimension
+ * of src except the axis.
+ */
+template <typename... Args_>
+void argmin_axis(Args_&&... args) {
+    _dispatch(
+      [](auto&& policy, auto dst, auto const& src, size_t axis) {
+          using view_type = std::remove_cvref_t<decltype(src)>;
+          using value_type = typename view_type::value_type;
+          constexpr auto dimension = view_type::dimension;
+
+          if (axis == dimension - 1) {
+              if (src.dims().back() == 0) { throw std::invalid_argument("empty axis"); }
+              if (dst.size() != _num_rows(src)) { throw std::invalid_argument("shape mismatch"); }
+
+              auto const n = src.dims().back();
+              _for_each_row(policy, _num_rows(src), [&](size_t r) { _element_at(dst, r) = _argmin_row<value_type>(_row_of(src, r), n).second; });
+              return;
+          }
+
+          ndarray<value_type, dimension - 1> best;
+          best.reshape(dst.dims());
+          min_axis(policy, best, src, axis);
+
+          // the first slice which equals to the minimum
+          auto const n = dst.dims().back();
+          fill(policy, dst, src.dims()[axis]);
+          for (size_t k = src.dims()[axis]; k-- > 0;) {
+              auto const slice = src.slice(axis, k);
+              _for_each_row(policy, _num_rows(dst), [&](size_t r) {
+                  auto const d = _row_of(dst, r);
+                  auto const s = _row_of(slice, r);
+                  auto const b = _row_of(std::as_const(best).view(), r);
+                  for (size_t i = 0; i < n; ++i) { d[i] = s[i] == b[i] ? k : d[i]; }
+              });
+          }
+      },
+      std::forward<Args_>(args)...);
+}
+} // namespace kangsw::inline containers::ops
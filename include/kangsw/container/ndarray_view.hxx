@@ -0,0 +1,242 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <version>
+#include "kangsw/helpers/counter.hxx"
+
+#if __cpp_lib_mdspan
+#include <mdspan>
+#endif
+
+namespace kangsw::inline containers {
+/**
+ * Non-owning N-dimensional view over strided memory.
+ *
+ * Every dimension has its own stride in elements, and data() points to the element at
+ * (0, ..., 0), thus slicing, transposition and sub-regions never copy elements.
+ * A stride of zero repeats the same elements along the axis. (broadcast)
+ *
+ * @code
+ *   ndarray<float, 3> image(480, 640, 3);
+ *   auto red = image.view().slice(2, 0);                  // 480x640, stride 3
+ *   auto roi = red.submatrix(100, 200, 64, 64);           // 64x64, no copy
+ *   for (auto const& idx : counter(roi.dims())) { roi[idx] *= 2; }
+ * @endcode
+ */
+template <typename Ty_, size_t Dim_ = 1>
+class ndarray_view {
+    static_assert(Dim_ > 0);
+
+public:
+    using value_type = std::remove_cv_t<Ty_>;
+    using element_type = Ty_;
+    using reference = Ty_&;
+    using pointer = Ty_*;
+    using size_type = size_t;
+    using dimension_type = std::array<size_type, Dim_>;
+    enum : size_t { dimension = Dim_ };
+
+public:
+    ndarray_view() noexcept = default;
+
+    /**
+     * Dense row-major view
+     */
+    ndarray_view(Ty_* data, dimension_type const& dims) noexcept :
+        _data(data), _dims(dims) {
+        for (size_t i = Dim_ - 1, step = 1; i != ~size_t{}; step *= _dims[i--]) { _strides[i] = step; }
+    }
+
+    ndarray_view(Ty_* data, dimension_type const& dims, dimension_type const& strides) noexcept :
+        _data(data), _dims(dims), _strides(strides) {}
+
+    template <typename Other_>
+    requires std::is_convertible_v<Other_ (*)[], Ty_ (*)[]>
+    ndarray_view(ndarray_view<Other_, Dim_> const& other) noexcept :
+        _data(other.data()), _dims(other.dims()), _strides(other.strides()) {}
+
+#if __cpp_lib_mdspan
+    template <typename Extents_, typename Layout_, typename Accessor_>
+    requires(Extents_::rank() == Dim_)
+    ndarray_view(std::mdspan<Ty_, Extents_, Layout_, Accessor_> const& span) :
+        _data(span.data_handle()) {
+        if (!span.is_strided()) { throw std::invalid_argument("mdspan layout is not strided"); }
+        for (size_t i = 0; i < Dim_; ++i) { _dims[i] = span.extent(i), _strides[i] = span.stride(i); }
+    }
+
+    /**
+     * Views with zero stride (broadcast) can't be represented by std::layout_stride.
+     */
+    auto to_mdspan() const {
+        using extents_type = std::dextents<size_type, Dim_>;
+        using mapping_type = std::layout_stride::mapping<extents_type>;
+        return std::mdspan<Ty_, extents_type, std::layout_stride>{_data, mapping_type{extents_type{_dims}, _strides}};
+    }
+#endif
+
+public:
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    reference operator()(Idxs_... index) const {
+        return _data[_reduce_index<false>({size_type(index)...})];
+    }
+
+    template <typename... Idxs_>
+    requires((sizeof...(Idxs_) == dimension) && (std::is_integral_v<Idxs_> && ...))
+    reference at(Idxs_... index) const {
+        return _data[_reduce_index<true>({size_type(index)...})];
+    }
+
+    reference operator[](dimension_type const& i) const { return _data[_reduce_index<false>(i)]; }
+    reference at(dimension_type const& i) const { return _data[_reduce_index<true>(i)]; }
+
+    auto data() const noexcept { return _data; }
+    auto dims() const noexcept { return _dims; }
+    auto strides() const noexcept { return _strides; }
+    size_type size() const noexcept { return std::reduce(_dims.begin(), _dims.end(), size_type(1), std::multiplies<>{}); }
+    bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * Whether elements are laid out densely in row-major order.
+     */
+    bool is_contiguous() const noexcept { return _strides == ndarray_view{_data, _dims}._strides; }
+
+    auto indices() const noexcept { return counter(_dims); }
+
+    /**
+     * Invokes fn on every element, in row-major order of the view.
+     */
+    template <typename Fn_>
+    void for_each(Fn_&& fn) const {
+        if (empty()) { return; }
+        if (is_contiguous()) { return void(std::for_each(_data, _data + size(), fn)); }
+
+        if constexpr (Dim_ == 1) {
+            for (size_type i = 0; i < _dims[0]; ++i) { fn(_data[i * _strides[0]]); }
+        }
+        else {
+            for (auto const& idx : indices()) { fn((*this)[idx]); }
+        }
+    }
+
+public:
+    /**
+     * Fixes index of given axis, which removes the axis from the view.
+     */
+    auto slice(size_t axis, size_type index) const requires(Dim_ > 1) {
+        _check_axis(axis);
+        if (index >= _dims[axis]) { throw std::invalid_argument("array index out of range"); }
+
+        ndarray_view<Ty_, Dim_ - 1> r;
+        r._data = _data + index * _strides[axis];
+        for (size_t i = 0, k = 0; i < Dim_; ++i) {
+            if (i == axis) { continue; }
+            r._dims[k] = _dims[i], r._strides[k++] = _strides[i];
+        }
+        return r;
+    }
+
+    /**
+     * Narrows given axis into [first, last), picking every step'th element.
+     */
+    ndarray_view slice(size_t axis, size_type first, size_type last, size_type step = 1) const {
+        _check_axis(axis);
+        if (first > last || last > _dims[axis] || step == 0) { throw std::invalid_argument("invalid slice range"); }
+
+        auto r = *this;
+        r._data += first * _strides[axis];
+        r._dims[axis] = (last - first + step - 1) / step;
+        r._strides[axis] *= step;
+        return r;
+    }
+
+    /**
+     * Reverses order of axes.
+     */
+    ndarray_view transpose() const noexcept {
+        auto r = *this;
+        std::reverse(r._dims.begin(), r._dims.end());
+        std::reverse(r._strides.begin(), r._strides.end());
+        return r;
+    }
+
+    /**
+     * Permutes axes; i'th axis of the result is axes[i]'th axis of this view.
+     */
+    ndarray_view transpose(std::array<size_t, Dim_> const& axes) const {
+        auto r = *this;
+        std::array<bool, Dim_> used = {};
+        for (size_t i = 0; i < Dim_; ++i) {
+            _check_axis(axes[i]);
+            if (std::exchange(used[axes[i]], true)) { throw std::invalid_argument("axes are not a permutation"); }
+            r._dims[i] = _dims[axes[i]], r._strides[i] = _strides[axes[i]];
+        }
+        return r;
+    }
+
+    ndarray_view subview(dimension_type const& offset, dimension_type const& extent) const {
+        auto r = *this;
+        for (size_t i = 0; i < Dim_; ++i) {
+            if (offset[i] + extent[i] > _dims[i]) { throw std::invalid_argument("subview out of range"); }
+            r._data += offset[i] * _strides[i];
+            r._dims[i] = extent[i];
+        }
+        return r;
+    }
+
+    ndarray_view submatrix(size_type row, size_type col, size_type rows, size_type cols) const requires(Dim_ == 2) {
+        return subview({row, col}, {rows, cols});
+    }
+
+    /**
+     * Broadcasts into new_dims, in numpy manner: dimensions are aligned from the last
+     * axis, and axes of extent 1 or missing ones are repeated with stride 0.
+     */
+    template <size_t NewDim_>
+    requires(NewDim_ >= Dim_)
+    auto broadcast(std::array<size_type, NewDim_> const& new_dims) const {
+        ndarray_view<Ty_, NewDim_> r;
+        r._data = _data, r._dims = new_dims, r._strides = {};
+
+        for (size_t i = 0; i < Dim_; ++i) {
+            auto const src = Dim_ - 1 - i, dst = NewDim_ - 1 - i;
+            if (_dims[src] == new_dims[dst]) { r._strides[dst] = _strides[src]; }
+            else if (_dims[src] != 1) { throw std::invalid_argument("shape is not broadcastable"); }
+        }
+        return r;
+    }
+
+    template <typename... Ints_>
+    requires(std::is_integral_v<Ints_>&&...)
+    auto broadcast(Ints_... new_dims) const { return broadcast(std::array{size_type(new_dims)...}); }
+
+private:
+    template <bool Check_>
+    size_type _reduce_index(dimension_type const& idx) const {
+        size_type index = 0;
+        for (size_t i = 0; i < Dim_; ++i) {
+            if constexpr (Check_) {
+                if (idx[i] >= _dims[i]) { throw std::invalid_argument("array index out of range"); }
+            }
+            index += idx[i] * _strides[i];
+        }
+        return index;
+    }
+
+    static void _check_axis(size_t axis) {
+        if (axis >= Dim_) { throw std::invalid_argument("axis out of range"); }
+    }
+
+    template <typename, size_t>
+    friend class ndarray_view;
+
+private:
+    Ty_* _data = nullptr;
+    dimension_type _dims = {};
+    dimension_type _strides = {};
+};
+} // namespace kangsw::inline containers
@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include "kangsw/container/circular_queue.hxx"
+
+namespace kangsw {
+/**
+ * Aggregates which can be maintained by rolling_window.
+ * Each of them updates its state in O(1) (amortized) per push, and supports
+ * full recompute over window contents, to resynchronize accumulated rounding errors.
+ */
+namespace rolling {
+template <typename Ty_>
+using _real_t = std::conditional_t<std::is_floating_point_v<Ty_>, Ty_, double>;
+
+/**
+ * Kahan-compensated sum
+ */
+struct sum {
+    template <typename Ty_>
+    struct state {
+        using real_type = _real_t<Ty_>;
+
+        void push(Ty_ v, size_t) { _add(real_type(v)); }
+        void pop(Ty_ v, size_t) { _add(-real_type(v)); }
+        real_type value() const { return _sum; }
+
+        void resync(std::span<Ty_ const> a, std::span<Ty_ const> b, size_t) {
+            auto reduce = [](auto span) { return std::reduce(std::execution::unseq, span.begin(), span.end(), real_type{}); };
+            _sum = reduce(a) + reduce(b), _compensation = {};
+        }
+
+    private:
+        void _add(real_type v) {
+            auto const y = v - _compensation;
+            auto const t = _sum + y;
+            _compensation = (t - _sum) - y;
+            _sum = t;
+        }
+
+        real_type _sum = {};
+        real_type _compensation = {};
+    };
+};
+
+/**
+ * Arithmetic mean, over Kahan-compensated sum
+ */
+struct mean {
+    template <typename Ty_>
+    struct state {
+        using real_type = _real_t<Ty_>;
+
+        void push(Ty_ v, size_t seq) { _sum.push(v, seq), ++_count; }
+        void pop(Ty_ v, size_t seq) { _sum.pop(v, seq), --_count; }
+        real_type value() const { return _count ? _sum.value() / real_type(_count) : real_type{}; }
+
+        void resync(std::span<Ty_ const> a, std::span<Ty_ const> b, size_t seq) {
+            _sum.resync(a, b, seq), _count = a.size() + b.size();
+        }
+
+    private:
+        sum::state<Ty_> _sum;
+        size_t _count = 0;
+    };
+};
+
+/**
+ * Population variance, with Welford's online algorithm which supports removal.
+ */
+struct variance {
+    template <typename Ty_>
+    struct state {
+        using real_type = _real_t<Ty_>;
+
+        void push(Ty_ v, size_t) {
+            auto const x = real_type(v);
+            auto const d = x - _mean;
+            _mean += d / real_type(++_count);
+            _m2 += d * (x - _mean);
+        }
+
+        void pop(Ty_ v, size_t) {
+            if (--_count == 0) { return void(_mean = _m2 = {}); }
+
+            auto const x = real_type(v);
+            auto const d = x - _mean;
+            _mean -= d / real_type(_count);
+            _m2 = std::max(real_type{}, _m2 - d * (x - _mean));
+        }
+
+        real_type value() const { return _count ? _m2 / real_type(_count) : real_type{}; }
+
+        void resync(std::span<Ty_ const> a, std::span<Ty_ const> b, size_t) {
+            // two-pass recompute is numerically better, and vectorizes well.
+            _count = a.size() + b.size();
+            if (_count == 0) { return void(_mean = _m2 = {}); }
+
+            auto reduce = [](auto span) { return std::reduce(std::execution::unseq, span.begin(), span.end(), real_type{}); };
+            _mean = (reduce(a) + reduce(b)) / real_type(_count);
+
+            auto square_diff = [this](auto span) {
+                return std::transform_reduce(
+                  std::execution::unseq, span.begin(), span.end(), real_type{}, std::plus<>{},
+                  [mean = _mean](Ty_ v) { return (real_type(v) - mean) * (real_type(v) - mean); });
+            };
+            _m2 = square_diff(a) + square_diff(b);
+        }
+
+    private:
+        size_t _count = 0;
+        real_type _mean = {};
+        real_type _m2 = {};
+    };
+};
+
+/**
+ * Monotonic deque of (sequence, value), whose front is the extremum of window.
+ */
+template <typename Compare_>
+struct _extremum {
+    template <typename Ty_>
+    struct state {
+        void push(Ty_ v, size_t seq) {
+            while (!_deque.empty() && !Compare_{}(_deque.back().second, v)) { _deque.pop_back(); }
+            if (_deque.is_full()) { _deque.reserve(std::max<size_t>(1, _deque.capacity() * 2)); }
+            _deque.push(std::pair{seq, v});
+        }
+
+        void pop(Ty_, size_t seq) {
+            if (!_deque.empty() && _deque.front().first == seq) { _deque.pop(); }
+        }
+
+        Ty_ value() const { return _deque.empty() ? Ty_{} : _deque.front().second; }
+
+        void resync(std::span<Ty_ const> a, std::span<Ty_ const> b, size_t seq) {
+            _deque.clear();
+            for (auto v : a) { push(v, seq++); }
+            for (auto v : b) { push(v, seq++); }
+        }
+
+    private:
+        circular_queue<std::pair<size_t, Ty_>> _deque{0};
+    };
+};
+
+struct min : _extremum<std::less<>> {};
+struct max : _extremum<std::greater<>> {};
+} // namespace rolling
+
+/**
+ * Sliding window over circular_queue, which keeps given rolling aggregates updated
+ * on every push, instead of recomputing them over whole window.
+ *
+ * @code
+ *   rolling_window<float, rolling::mean, rolling::variance, rolling::max> w{256};
+ *   w.push(sample);
+ *   auto var = w.get<rolling::variance>();
+ * @endcode
+ */
+template <typename Ty_, typename... Ops_>
+class rolling_window {
+public:
+    using value_type = Ty_;
+
+public:
+    explicit rolling_window(size_t window_size) :
+        _window(window_size) {}
+
+public:
+    void push(Ty_ value) {
+        if (_window.capacity() == 0) { return; }
+        if (_window.is_full()) {
+            auto const old = _window.front();
+            auto const old_seq = _seq - _window.size();
+            (std::get<_state_t<Ops_>>(_states).pop(old, old_seq), ...);
+            _window.pop();
+        }
+
+        _window.push(value);
+        (std::get<_state_t<Ops_>>(_states).push(value, _seq), ...);
+        ++_seq;
+    }
+
+    template <typename Op_>
+    auto get() const { return std::get<_state_t<Op_>>(_states).value(); }
+
+    /**
+     * Recomputes every aggregate from window contents.
+     * Call periodically for long-running floating point windows.
+     */
+    void resync() {
+        auto [a, b] = _window.as_spans();
+        auto const first_seq = _seq - _window.size();
+        (std::get<_state_t<Ops_>>(_states).resync(a, b, first_seq), ...);
+    }
+
+    void clear() {
+        _window.clear();
+        resync();
+    }
+
+    size_t size() const { return _window.size(); }
+    size_t capacity() const { return _window.capacity(); }
+    bool is_full() const { return _window.is_full(); }
+    auto const& window() const { return _window; }
+
+private:
+    template <typename Op_>
+    using _state_t = typename Op_::template state<Ty_>;
+
+    circular_queue<Ty_> _window;
+    std::tuple<_state_t<Ops_>...> _states;
+    size_t _seq = 0;
+};
+} // namespace kangsw
@@ -0,0 +1,291 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "kangsw/container/ndarray.hxx"
+#include "kangsw/container/ndarray_view.hxx"
+#include "kangsw/helpers/zip.hxx"
+
+namespace kangsw::inline containers {
+enum class sparse_format {
+    csr, // compressed rows; fast row iteration
+    csc, // compressed columns; fast column iteration
+};
+
+template <typename Ty_, sparse_format Format_ = sparse_format::csr, typename Index_ = uint32_t>
+class sparse_matrix;
+
+struct _is_nonzero {
+    template <typename Ty_>
+    bool operator()(Ty_ const& v) const { return v != Ty_{}; }
+};
+
+/**
+ * Collects (row, col, value) triplets in any order, then compresses them into
+ * sparse_matrix of either format.
+ *
+ * @code
+ *   sparse_builder<float> b(20000, 20000);
+ *   for (auto& [track, det, cost] : candidates) { b.push(track, det, cost); }
+ *   auto costs = b.build();                 // CSR
+ * @endcode
+ */
+template <typename Ty_, typename Index_ = uint32_t>
+class sparse_builder {
+public:
+    struct triplet {
+        Index_ row;
+        Index_ col;
+        Ty_ value;
+    };
+
+public:
+    sparse_builder(size_t rows, size_t cols) :
+        _dims{rows, cols} {
+        if (std::max(rows, cols) > size_t(std::numeric_limits<Index_>::max())) { throw std::invalid_argument("index type too narrow"); }
+    }
+
+public:
+    void reserve(size_t n) { _triplets.reserve(n); }
+    void push(size_t row, size_t col, Ty_ value) {
+        if (row >= _dims[0] || col >= _dims[1]) { throw std::invalid_argument("array index out of range"); }
+        _triplets.push_back({Index_(row), Index_(col), std::move(value)});
+    }
+
+    /**
+     * Appends range of triplets, each of which is destructurable as (row, col, value).
+     */
+    template <typename Range_>
+    void append(Range_ const& triplets) {
+        for (auto const& [row, col, value] : triplets) { push(size_t(row), size_t(col), value); }
+    }
+
+    size_t size() const noexcept { return _triplets.size(); }
+    auto dims() const noexcept { return _dims; }
+    void clear() noexcept { _triplets.clear(); }
+
+    /**
+     * Duplicated entries are folded by combine, which sums them by default.
+     */
+    template <sparse_format Format_ = sparse_format::csr, typename Combine_ = std::plus<>>
+    sparse_matrix<Ty_, Format_, Index_> build(Combine_&& combine = {}) const {
+        constexpr bool by_row = Format_ == sparse_format::csr;
+        auto const num_major = _dims[!by_row];
+        auto const major_of = [](triplet const& t) { return by_row ? t.row : t.col; };
+        auto const minor_of = [](triplet const& t) { return by_row ? t.col : t.row; };
+
+        // counting sort by major axis, then sort each line by minor index.
+        std::vector<size_t> offsets(num_major + 1);
+        for (auto& t : _triplets) { ++offsets[major_of(t) + 1]; }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<triplet const*> sorted(_triplets.size());
+        auto cursor = offsets;
+        for (auto& t : _triplets) { sorted[cursor[major_of(t)]++] = &t; }
+
+        sparse_matrix<Ty_, Format_, Index_> r;
+        r._dims = _dims;
+        r._offsets.assign(num_major + 1, 0);
+        r._indices.reserve(sorted.size());
+        r._values.reserve(sorted.size());
+
+        for (size_t major = 0; major < num_major; ++major) {
+            auto const first = sorted.begin() + offsets[major], last = sorted.begin() + offsets[major + 1];
+            std::stable_sort(first, last, [&](auto a, auto b) { return minor_of(*a) < minor_of(*b); });
+
+            for (auto it = first; it != last; ++it) {
+                if (it != first && minor_of(**it) == r._indices.back()) {
+                    r._values.back() = combine(r._values.back(), (*it)->value);
+                    continue;
+                }
+                r._indices.push_back(minor_of(**it));
+                r._values.push_back((*it)->value);
+            }
+            r._offsets[major + 1] = r._indices.size();
+        }
+
+        return r;
+    }
+
+private:
+    std::array<size_t, 2> _dims;
+    std::vector<triplet> _triplets;
+};
+
+/**
+ * Compressed sparse matrix, in CSR or CSC format.
+ *
+ * Entries of each major line (row of CSR, column of CSC) are sorted by minor index, and
+ * absent entries are simply not stored; what absence means is up to the consumer.
+ * Transposition swaps the format without touching any entry.
+ */
+template <typename Ty_, sparse_format Format_, typename Index_>
+class sparse_matrix {
+    static constexpr bool _by_row = Format_ == sparse_format::csr;
+
+public:
+    using value_type = Ty_;
+    using index_type = Index_;
+    using size_type = size_t;
+    using dimension_type = std::array<size_type, 2>;
+    static constexpr sparse_format format = Format_;
+    enum : size_t { dimension = 2 };
+
+public:
+    sparse_matrix() noexcept = default;
+
+    /**
+     * Compresses elements of a dense view, which satisfy is_present.
+     */
+    template <typename Other_, typename Pred_ = _is_nonzero>
+    explicit sparse_matrix(ndarray_view<Other_, 2> const& dense, Pred_&& is_present = {}) :
+        _dims(dense.dims()) {
+        auto const num_major = _dims[!_by_row], num_minor = _dims[_by_row];
+        _offsets.assign(num_major + 1, 0);
+
+        for (size_t major = 0; major < num_major; ++major) {
+            for (size_t minor = 0; minor < num_minor; ++minor) {
+                auto const& v = _by_row ? dense(major, minor) : dense(minor, major);
+                if (!is_present(v)) { continue; }
+                _indices.push_back(Index_(minor));
+                _values.push_back(v);
+            }
+            _offsets[major + 1] = _indices.size();
+        }
+    }
+
+public:
+    size_type rows() const noexcept { return _dims[0]; }
+    size_type cols() const noexcept { return _dims[1]; }
+    dimension_type dims() const noexcept { return _dims; }
+    size_type nnz() const noexcept { return _values.size(); }
+    bool empty() const noexcept { return _values.empty(); }
+
+    /**
+     * Number of major lines; rows of CSR, or columns of CSC.
+     */
+    size_type num_lines() const noexcept { return _dims[!_by_row]; }
+
+    std::span<Index_ const> indices(size_type major) const { return {_indices.data() + _offsets[major], _line_size(major)}; }
+    std::span<Ty_ const> values(size_type major) const { return {_values.data() + _offsets[major], _line_size(major)}; }
+    std::span<Ty_> values(size_type major) { return {_values.data() + _offsets[major], _line_size(major)}; }
+
+    /**
+     * Iterates (minor index, value) pairs of a major line.
+     */
+    auto line(size_type major) const { return zip(indices(major), values(major)); }
+    auto line(size_type major) { return zip(indices(major), values(major)); }
+
+    auto row(size_type r) const requires(_by_row) { return line(r); }
+    auto row(size_type r) requires(_by_row) { return line(r); }
+    auto col(size_type c) const requires(!_by_row) { return line(c); }
+    auto col(size_type c) requires(!_by_row) { return line(c); }
+
+    /**
+     * Pointer to stored entry, or nullptr if absent; binary search on the major line.
+     */
+    Ty_ const* find(size_type row, size_type col) const {
+        if (row >= _dims[0] || col >= _dims[1]) { throw std::invalid_argument("array index out of range"); }
+        auto const major = _by_row ? row : col, minor = _by_row ? col : row;
+        auto const idx = indices(major);
+        auto const it = std::lower_bound(idx.begin(), idx.end(), Index_(minor));
+        return it != idx.end() && *it == minor ? &_values[_offsets[major] + (it - idx.begin())] : nullptr;
+    }
+
+    Ty_* find(size_type row, size_type col) { return const_cast<Ty_*>(std::as_const(*this).find(row, col)); }
+
+    bool contains(size_type row, size_type col) const { return find(row, col) != nullptr; }
+    Ty_ value_or(size_type row, size_type col, Ty_ absent) const {
+        auto const p = find(row, col);
+        return p ? *p : absent;
+    }
+
+    auto offsets() const noexcept { return std::span<size_t const>{_offsets}; }
+    auto indices() const noexcept { return std::span<Index_ const>{_indices}; }
+    auto values() const noexcept { return std::span<Ty_ const>{_values}; }
+
+public:
+    ndarray<Ty_, 2> to_dense(Ty_ absent = {}) const {
+        ndarray<Ty_, 2> r(_dims[0], _dims[1]);
+        std::fill(r.begin(), r.end(), absent);
+        for (size_t major = 0; major < num_lines(); ++major) {
+            for (auto [minor, v] : line(major)) { (_by_row ? r(major, minor) : r(minor, major)) = v; }
+        }
+        return r;
+    }
+
+    /**
+     * Same matrix in the other format; O(nnz + rows + cols)
+     */
+    template <sparse_format To_>
+    sparse_matrix<Ty_, To_, Index_> convert() const {
+        if constexpr (To_ == Format_) { return *this; }
+        else {
+            // transposition of a compressed matrix via counting sort, which keeps entries sorted.
+            auto const num_minor = _dims[_by_row];
+            sparse_matrix<Ty_, To_, Index_> r;
+            r._dims = _dims;
+            r._offsets.assign(num_minor + 1, 0);
+            for (auto minor : _indices) { ++r._offsets[minor + 1]; }
+            std::partial_sum(r._offsets.begin(), r._offsets.end(), r._offsets.begin());
+
+            r._indices.resize(nnz());
+            r._values.resize(nnz());
+            auto cursor = r._offsets;
+            for (size_t major = 0; major < num_lines(); ++major) {
+                for (auto [minor, v] : line(major)) {
+                    auto const pos = cursor[minor]++;
+                    r._indices[pos] = Index_(major), r._values[pos] = v;
+                }
+            }
+            return r;
+        }
+    }
+
+    auto to_csr() const { return convert<sparse_format::csr>(); }
+    auto to_csc() const { return convert<sparse_format::csc>(); }
+
+    /**
+     * Transposed matrix, which shares layout of this one in the other format.
+     */
+    auto transpose() const& {
+        sparse_matrix<Ty_, _by_row ? sparse_format::csc : sparse_format::csr, Index_> r;
+        r._dims = {_dims[1], _dims[0]}, r._offsets = _offsets, r._indices = _indices, r._values = _values;
+        return r;
+    }
+
+    auto transpose() && {
+        sparse_matrix<Ty_, _by_row ? sparse_format::csc : sparse_format::csr, Index_> r;
+        r._dims = {_dims[1], _dims[0]};
+        r._offsets = std::move(_offsets), r._indices = std::move(_indices), r._values = std::move(_values);
+        return r;
+    }
+
+    bool operator==(sparse_matrix const& r) const = default;
+
+private:
+    size_type _line_size(size_type major) const {
+        if (major >= num_lines()) { throw std::invalid_argument("array index out of range"); }
+        return _offsets[major + 1] - _offsets[major];
+    }
+
+    template <typename, sparse_format, typename>
+    friend class sparse_matrix;
+
+    template <typename, typename>
+    friend class sparse_builder;
+
+private:
+    dimension_type _dims = {};
+    std::vector<size_t> _offsets = {0};
+    std::vector<Index_> _indices;
+    std::vector<Ty_> _values;
+};
+} // namespace kangsw::inline containers
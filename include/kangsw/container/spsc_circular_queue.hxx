@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace kangsw {
+// fixed rather than std::hardware_destructive_interference_size, which may vary with compiler
+//flags and thus must not affect class layout. (GCC warns of it by -Winterference-size)
+inline constexpr size_t _cache_line_size = 64;
+
+/**
+ * Lock-free bounded queue for exactly one producer thread and one consumer thread.
+ * push 계열 함수는 producer 스레드에서만, pop 계열 함수는 consumer 스레드에서만 호출해야 합니다.
+ *
+ * head/tail are placed on separate cache lines, and each side keeps a cached copy of
+ * the opposite index, which is refreshed only when the queue looks full/empty.
+ */
+template <typename Ty_>
+class spsc_circular_queue {
+public:
+    using value_type = Ty_;
+
+public:
+    explicit spsc_circular_queue(size_t capacity) :
+        _capacity(capacity + 1), _data(std::allocator<Ty_>{}.allocate(_capacity)) {}
+
+    spsc_circular_queue(const spsc_circular_queue&) = delete;
+    spsc_circular_queue& operator=(const spsc_circular_queue&) = delete;
+
+    ~spsc_circular_queue() {
+        for (auto i = _tail.load(); i != _head.load(); i = _next(i)) { _data[i].~Ty_(); }
+        std::allocator<Ty_>{}.deallocate(_data, _capacity);
+    }
+
+public:
+    template <typename... Args_>
+    bool try_emplace(Args_&&... args) {
+        auto const head = _head.load(std::memory_order_relaxed);
+        auto const next = _next(head);
+        if (next == _tail_cached && next == (_tail_cached = _tail.load(std::memory_order_acquire))) {
+            return false;
+        }
+
+        new (_data + head) Ty_(std::forward<Args_>(args)...);
+        _head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(Ty_ const& s) { return try_emplace(s); }
+    bool try_push(Ty_&& s) { return try_emplace(std::move(s)); }
+
+    bool try_pop(Ty_& out) {
+        auto const tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head_cached && tail == (_head_cached = _head.load(std::memory_order_acquire))) {
+            return false;
+        }
+
+        out = std::move(_data[tail]);
+        _data[tail].~Ty_();
+        _tail.store(_next(tail), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Pushes up to n elements at once, copying at most two contiguous spans.
+     * @return number of pushed elements
+     */
+    size_t push_n(Ty_ const* src, size_t n) {
+        auto const head = _head.load(std::memory_order_relaxed);
+        if (_num_free(head, _tail_cached) < n) { _tail_cached = _tail.load(std::memory_order_acquire); }
+        n = std::min(n, _num_free(head, _tail_cached));
+
+        auto const first = std::min(n, _capacity - head);
+        _copy_in(_data + head, src, first);
+        _copy_in(_data, src + first, n - first);
+
+        _head.store(_jmp(head, n), std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * Pops up to n elements at once into dst, which must hold n constructed elements.
+     * @return number of popped elements
+     */
+    size_t pop_n(Ty_* dst, size_t n) {
+        auto const tail = _tail.load(std::memory_order_relaxed);
+        if (_num_filled(_head_cached, tail) < n) { _head_cached = _head.load(std::memory_order_acquire); }
+        n = std::min(n, _num_filled(_head_cached, tail));
+
+        auto const first = std::min(n, _capacity - tail);
+        _move_out(dst, _data + tail, first);
+        _move_out(dst + first, _data, n - first);
+
+        _tail.store(_jmp(tail, n), std::memory_order_release);
+        return n;
+    }
+
+    // below are only snapshots, if called while the other side is running.
+    size_t size() const { return _num_filled(_head.load(std::memory_order_acquire), _tail.load(std::memory_order_acquire)); }
+    bool empty() const { return size() == 0; }
+    constexpr size_t capacity() const { return _capacity - 1; }
+
+private:
+    size_t _next(size_t i) const noexcept { return ++i == _capacity ? 0 : i; }
+    size_t _jmp(size_t i, size_t n) const noexcept { return (i += n) >= _capacity ? i - _capacity : i; }
+
+    size_t _num_filled(size_t head, size_t tail) const noexcept {
+        return head >= tail ? head - tail : head + _capacity - tail;
+    }
+
+    size_t _num_free(size_t head, size_t tail) const noexcept {
+        return _capacity - 1 - _num_filled(head, tail);
+    }
+
+    static void _copy_in(Ty_* dst, Ty_ const* src, size_t n) {
+        if constexpr (std::is_trivially_copyable_v<Ty_>) {
+            if (n) { std::memcpy(dst, src, n * sizeof(Ty_)); }
+        }
+        else {
+            std::uninitialized_copy_n(src, n, dst);
+        }
+    }
+
+    static void _move_out(Ty_* dst, Ty_* src, size_t n) {
+        if constexpr (std::is_trivially_copyable_v<Ty_>) {
+            if (n) { std::memcpy(dst, src, n * sizeof(Ty_)); }
+        }
+        else {
+            std::move(src, src + n, dst);
+            std::destroy_n(src, n);
+        }
+    }
+
+private:
+    // producer side
+    alignas(_cache_line_size) std::atomic_size_t _head = 0;
+    size_t _tail_cached = 0;
+
+    // consumer side
+    alignas(_cache_line_size) std::atomic_size_t _tail = 0;
+    size_t _head_cached = 0;
+
+    alignas(_cache_line_size) size_t const _capacity;
+    Ty_* const _data;
+};
+} // namespace kangsw
@@ -0,0 +1,41 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <new>
+
+namespace kangsw::inline misc {
+/**
+ * Allocator which aligns every allocation to Align_ bytes, or alignof(Ty_) if greater.
+ */
+template <typename Ty_, size_t Align_ = 64>
+class aligned_allocator {
+    static_assert(std::has_single_bit(Align_));
+
+public:
+    using value_type = Ty_;
+    static constexpr size_t alignment = Align_ > alignof(Ty_) ? Align_ : alignof(Ty_);
+
+    template <typename Other_>
+    struct rebind {
+        using other = aligned_allocator<Other_, Align_>;
+    };
+
+public:
+    aligned_allocator() noexcept = default;
+
+    template <typename Other_>
+    aligned_allocator(aligned_allocator<Other_, Align_> const&) noexcept {}
+
+    Ty_* allocate(size_t n) {
+        if (n > size_t(-1) / sizeof(Ty_)) { throw std::bad_array_new_length(); }
+        return static_cast<Ty_*>(::operator new(n * sizeof(Ty_), std::align_val_t{alignment}));
+    }
+
+    void deallocate(Ty_* p, size_t n) noexcept {
+        ::operator delete(p, n * sizeof(Ty_), std::align_val_t{alignment});
+    }
+
+    template <typename Other_>
+    bool operator==(aligned_allocator<Other_, Align_> const&) const noexcept { return true; }
+};
+} // namespace kangsw::inline misc
@@ -1,7 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <iterator>
 #include <numeric>
+#include <stdexcept>
+#include <utility>
 #include "tuple_for_each.hxx"
 
 namespace kangsw::inline counters {
@@ -39,6 +43,7 @@ public:
         count_(rhs.count_) {
         ;
     }
+    constexpr _counter& operator=(_counter const& rhs) noexcept = default;
 
 public:
     template <typename Integer_>
@@ -113,6 +118,7 @@ public:
         count_(rhs.count_) {
         ;
     }
+    constexpr _counter& operator=(_counter const& rhs) noexcept = default;
 
 public:
     constexpr friend _counter operator-(_counter c, difference_type n) { return _counter(c.count_ + n); }
@@ -174,25 +180,88 @@ private:
 
 class _counter_end_marker_t {};
 
+constexpr uint64_t _mulhi(uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    return uint64_t(static_cast<unsigned __int128>(a) * b >> 64);
+#else
+    auto const a_lo = a & 0xffffffff, a_hi = a >> 32, b_lo = b & 0xffffffff, b_hi = b >> 32;
+    auto const mid = (a_lo * b_lo >> 32) + (a_hi * b_lo & 0xffffffff) + a_lo * b_hi;
+    return a_hi * b_hi + (a_hi * b_lo >> 32) + (mid >> 32);
+#endif
+}
+
+/**
+ * Unsigned division by an invariant divisor, with multiply and shifts.
+ * @see Granlund, Montgomery. "Division by Invariant Integers using Multiplication"
+ */
+class _magic_divider {
+public:
+    constexpr _magic_divider() noexcept = default;
+    constexpr explicit _magic_divider(uint64_t divisor) noexcept {
+        if (divisor == 0) { return; } // never used; dimension of zero has no element
+
+        uint32_t l = 0;
+        while (l < 64 && (uint64_t(1) << l) < divisor) { ++l; }
+
+        // magic = floor(2^64 * (2^l - d) / d) + 1, by long division since 2^l - d < d
+        uint64_t rem = (l == 64 ? 0 : uint64_t(1) << l) - divisor, quot = 0;
+        for (int i = 0; i < 64; ++i) {
+            bool const carry = rem >> 63;
+            rem <<= 1, quot <<= 1;
+            if (carry || rem >= divisor) { rem -= divisor, quot |= 1; }
+        }
+
+        _magic = quot + 1;
+        _shift1 = l ? 1 : 0;
+        _shift2 = l ? l - 1 : 0;
+    }
+
+    constexpr uint64_t divide(uint64_t n) const noexcept {
+        auto const t = _mulhi(_magic, n);
+        return (t + ((n - t) >> _shift1)) >> _shift2;
+    }
+
+private:
+    uint64_t _magic = 0;
+    uint32_t _shift1 = 0;
+    uint32_t _shift2 = 0;
+};
+
+/**
+ * N-dimensional counter; random access iterator over row-major linear index.
+ *
+ * Increments carry coordinates incrementally, and random jumps decompose the linear index
+ * with precomputed magic divisors, thus parallel algorithms can split the range in O(1).
+ */
 template <typename Ty_, size_t Dim_>
 class _counter {
 public:
     enum { num_dimension = Dim_ };
 
-    using iterator_category = std::forward_iterator_tag;
+    using dimension = std::array<Ty_, num_dimension>;
+
+    using iterator_category = std::random_access_iterator_tag;
     using difference_type = ptrdiff_t;
-    using value_type = Ty_;
-    using reference = value_type&;
-    using pointer = value_type*;
+    using value_type = dimension;
+    using reference = dimension; // by value, as operator[] yields coordinates not stored anywhere
+    using pointer = dimension const*;
 
-    using dimension = std::array<Ty_, num_dimension>;
+public:
+    constexpr _counter() noexcept = default;
+    constexpr _counter(dimension const& max, size_t index) noexcept :
+        max(max), _index(index) {
+        for (size_t i = 1; i < Dim_; ++i) { _dividers[i - 1] = _magic_divider(uint64_t(max[i])); }
+        _decompose();
+    }
 
 public:
     template <typename... Ints_>
     constexpr _counter& fetch_from(Ints_&&... ints) { return *this; }
 
-    constexpr auto& operator[](size_t dim) const { return current[dim]; }
-    constexpr auto& operator[](size_t dim) { return current[dim]; }
+    /**
+     * Coordinates n steps ahead.
+     */
+    constexpr reference operator[](difference_type n) const noexcept { return *(*this + n); }
 
     template <size_t N_ = Dim_ - 1>
     constexpr void incr() {
@@ -201,42 +270,79 @@ public:
         }
         else {
             if (++current[N_] == max[N_]) {
-                current[N_] = value_type{};
+                current[N_] = Ty_{};
                 incr<N_ - 1>();
             }
         }
     }
 
-    constexpr _counter& operator++() { return incr(), *this; }
+    constexpr _counter& operator++() { return ++_index, incr(), *this; }
     constexpr _counter operator++(int) {
         auto cpy = *this;
-        incr();
+        ++*this;
         return cpy;
     }
 
-    constexpr bool operator==(_counter const& o) const { return current == o.current; }
+    constexpr _counter& operator--() { return *this -= 1; }
+    constexpr _counter operator--(int) {
+        auto cpy = *this;
+        --*this;
+        return cpy;
+    }
+
+    constexpr _counter& operator+=(difference_type n) { return _index += n, _decompose(), *this; }
+    constexpr _counter& operator-=(difference_type n) { return _index -= n, _decompose(), *this; }
+    constexpr friend _counter operator+(_counter c, difference_type n) { return c += n; }
+    constexpr friend _counter operator+(difference_type n, _counter c) { return c += n; }
+    constexpr friend _counter operator-(_counter c, difference_type n) { return c -= n; }
+    constexpr difference_type operator-(_counter const& o) const { return difference_type(_index) - difference_type(o._index); }
+
+    constexpr bool operator==(_counter const& o) const { return _index == o._index; }
     constexpr bool operator!=(_counter const& o) const { return !(*this == o); }
+    constexpr auto operator<=>(_counter const& o) const { return _index <=> o._index; }
 
     // constexpr bool operator==(_counter_end_marker_t) const { return current[0] == max[0]; }
     // constexpr bool operator!=(_counter_end_marker_t) const { return current[0] != max[0]; }
 
-    constexpr auto& operator*() const { return current; }
-    constexpr auto operator->() const { return &current; }
-    constexpr auto& operator*() { return current; }
-    constexpr auto operator->() { return &current; }
+    constexpr reference operator*() const { return current; }
+    constexpr pointer operator->() const { return &current; }
+
+    /**
+     * Row-major linear index of current.
+     */
+    constexpr size_t index() const noexcept { return _index; }
+
+private:
+    constexpr void _decompose() noexcept {
+        auto k = uint64_t(_index);
+        for (size_t i = Dim_ - 1; i > 0; --i) {
+            auto const q = _dividers[i - 1].divide(k);
+            current[i] = Ty_(k - q * uint64_t(max[i]));
+            k = q;
+        }
+
+        if (k < uint64_t(max[0])) { current[0] = Ty_(k); }
+        else { current = max; } // end
+    }
 
 public:
-    dimension max;
-    dimension current;
+    dimension max = {};
+    dimension current = {};
+
+private:
+    size_t _index = 0;
+    std::array<_magic_divider, Dim_ - 1> _dividers = {};
 };
 
 template <typename SizeTy_, size_t Dim_>
 struct _count_index {
     using iterator = _counter<SizeTy_, Dim_>;
     using dimension = typename iterator::dimension;
-    constexpr iterator begin() const { return _counter<SizeTy_, Dim_>{max, {}}; }
-    // constexpr iterator end() const { return _counter<SizeTy_, Dim_>{max, max}; }
-    constexpr iterator end() const { return _counter<SizeTy_, Dim_>{max, max}; }
+    constexpr iterator begin() const { return {max, 0}; }
+    constexpr iterator end() const { return {max, size()}; }
+    constexpr size_t size() const {
+        return std::reduce(max.begin(), max.end(), size_t(1), [](size_t a, size_t b) { return a * b; });
+    }
 
     dimension max;
 };
@@ -286,4 +392,146 @@ constexpr auto counter(std::array<SizeTy_, Dim_> const& idx) {
     return counter;
 }
 
+/**
+ * Block of N-dimensional index space, [offset, offset + extent)
+ */
+template <typename SizeTy_, size_t Dim_>
+struct tile {
+    using dimension = std::array<SizeTy_, Dim_>;
+
+    constexpr SizeTy_ size() const noexcept {
+        return std::reduce(extent.begin(), extent.end(), SizeTy_(1), std::multiplies<>{});
+    }
+
+    /**
+     * Invokes fn(index) in row-major order, where index is absolute, not tile-local.
+     */
+    template <typename Fn_>
+    constexpr void for_each(Fn_&& fn) const {
+        if (size() == 0) { return; }
+
+        auto index = offset;
+        auto const inner_end = offset[Dim_ - 1] + extent[Dim_ - 1];
+        for (;;) {
+            for (index[Dim_ - 1] = offset[Dim_ - 1]; index[Dim_ - 1] < inner_end; ++index[Dim_ - 1]) { fn(std::as_const(index)); }
+
+            size_t axis = Dim_ - 1;
+            for (; axis-- > 0;) {
+                if (++index[axis] < offset[axis] + extent[axis]) { break; }
+                index[axis] = offset[axis];
+            }
+            if (axis == size_t(-1)) { return; }
+        }
+    }
+
+    dimension offset;
+    dimension extent;
+};
+
+/**
+ * Random access iterator over tiles; k'th tile is in row-major order of the tile grid.
+ */
+template <typename SizeTy_, size_t Dim_>
+class _tile_iterator {
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type = ptrdiff_t;
+    using value_type = tile<SizeTy_, Dim_>;
+    using reference = value_type;
+    using pointer = void;
+    using dimension = std::array<SizeTy_, Dim_>;
+
+public:
+    constexpr _tile_iterator() noexcept = default;
+    constexpr _tile_iterator(dimension const& dims, dimension const& tile_extent, dimension const& grid, size_t index) noexcept :
+        _dims(dims), _extent(tile_extent), _grid(grid), _index(index) {}
+
+public:
+    constexpr value_type operator*() const noexcept { return (*this)[0]; }
+
+    constexpr value_type operator[](difference_type n) const noexcept {
+        value_type r;
+        for (size_t i = Dim_, k = _index + n; i-- > 0; k /= _grid[i]) {
+            r.offset[i] = SizeTy_(k % _grid[i] * _extent[i]);
+            r.extent[i] = std::min<SizeTy_>(_extent[i], _dims[i] - r.offset[i]);
+        }
+        return r;
+    }
+
+    constexpr _tile_iterator& operator++() noexcept { return ++_index, *this; }
+    constexpr _tile_iterator operator++(int) noexcept { return ++_index, _tile_iterator{*this} -= 1; }
+    constexpr _tile_iterator& operator--() noexcept { return --_index, *this; }
+    constexpr _tile_iterator operator--(int) noexcept { return --_index, _tile_iterator{*this} += 1; }
+    constexpr _tile_iterator& operator+=(difference_type n) noexcept { return _index += n, *this; }
+    constexpr _tile_iterator& operator-=(difference_type n) noexcept { return _index -= n, *this; }
+
+    constexpr friend _tile_iterator operator+(_tile_iterator it, difference_type n) noexcept { return it += n; }
+    constexpr friend _tile_iterator operator+(difference_type n, _tile_iterator it) noexcept { return it += n; }
+    constexpr friend _tile_iterator operator-(_tile_iterator it, difference_type n) noexcept { return it -= n; }
+    constexpr difference_type operator-(_tile_iterator const& o) const noexcept { return difference_type(_index) - difference_type(o._index); }
+
+    constexpr bool operator==(_tile_iterator const& o) const noexcept { return _index == o._index; }
+    constexpr auto operator<=>(_tile_iterator const& o) const noexcept { return _index <=> o._index; }
+
+private:
+    dimension _dims = {};
+    dimension _extent = {};
+    dimension _grid = {};
+    size_t _index = 0;
+};
+
+template <typename SizeTy_, size_t Dim_>
+struct _tile_range {
+    using iterator = _tile_iterator<SizeTy_, Dim_>;
+    using dimension = typename iterator::dimension;
+
+    constexpr iterator begin() const noexcept { return {dims, extent, grid, 0}; }
+    constexpr iterator end() const noexcept { return {dims, extent, grid, size()}; }
+    constexpr size_t size() const noexcept {
+        return std::reduce(grid.begin(), grid.end(), size_t(1), std::multiplies<>{});
+    }
+    constexpr auto operator[](size_t k) const noexcept { return begin()[k]; }
+
+    dimension dims;
+    dimension extent;
+    dimension grid;
+};
+
+/**
+ * Partitions an N-dimensional shape into blocks of tile_extent; blocks on the upper edges
+ * are clipped. Since tiles are random-accessible, the range can be split evenly by
+ * for_each_partition() or thread_pool::add_bulk_task() without walking over it.
+ *
+ * @code
+ *   auto t = tiles(image.dims(), {64, 64});
+ *   for_each_partition(std::execution::par, t.begin(), t.end(), [&](auto const& tile) {
+ *       auto block = image.view().subview(tile.offset, tile.extent);
+ *       ...
+ *   }, num_threads);
+ * @endcode
+ */
+template <typename SizeTy_, size_t Dim_>
+constexpr auto tiles(std::array<SizeTy_, Dim_> const& dims, std::array<SizeTy_, Dim_> const& tile_extent) {
+    _tile_range<SizeTy_, Dim_> r{dims, tile_extent, {}};
+    for (size_t i = 0; i < Dim_; ++i) {
+        if (tile_extent[i] == 0) { throw std::invalid_argument("tile extent must be positive"); }
+        r.grid[i] = (dims[i] + tile_extent[i] - 1) / tile_extent[i];
+    }
+    return r;
+}
+
+/**
+ * Tiles of at most max_tile_size indices, which are shaped from the innermost axis, so that
+ * each tile covers whole rows where possible. e.g. pass L2 size / element size.
+ */
+template <typename SizeTy_, size_t Dim_>
+constexpr auto tiles(std::array<SizeTy_, Dim_> const& dims, size_t max_tile_size) {
+    std::array<SizeTy_, Dim_> extent;
+    for (size_t i = Dim_; i-- > 0;) {
+        extent[i] = SizeTy_(std::max<size_t>(1, std::min<size_t>(dims[i], max_tile_size)));
+        max_tile_size = std::max<size_t>(1, max_tile_size / extent[i]);
+    }
+    return tiles(dims, extent);
+}
+
 } // namespace kangsw::inline counters
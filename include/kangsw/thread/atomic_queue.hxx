@@ -46,6 +46,22 @@ public:
         return true;
     }
 
+    /**
+     * Pops up to max_count elements under single lock.
+     * @return number of popped elements
+     */
+    template <typename OutIt_>
+    size_t try_pop_n(OutIt_ out, size_t max_count) {
+        write_lock_type lock(queue_lock_);
+        size_t count = 0;
+
+        for (; count < max_count && !queue_.empty(); ++count) {
+            *out++ = std::move(queue_.back());
+            queue_.pop_back();
+        }
+        return count;
+    }
+
     bool empty() const {
         read_lock_type lock(queue_lock_);
         return queue_.empty();
@@ -0,0 +1,156 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <ki6080@gmail.com> wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.      Seungwoo Kang.
+ * ----------------------------------------------------------------------------
+ */
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "kangsw/thread/thread_pool.hxx"
+
+namespace kangsw:: inline threads {
+inline namespace KANGSW_THREAD_POOL_ABI {
+/**
+ * Serial executor which runs on top of thread_pool.
+ *
+ * Tasks added to a strand are executed in FIFO order, and never run concurrently with
+ * each other. Different strands freely share workers of the pool.
+ * Pending tasks are kept in an intrusive lock-free MPSC list, and at most one drain task
+ * per strand is queued on the pool at a time, which executes up to 'batch_size' tasks
+ * before yielding the worker back to the pool.
+ *
+ * Destroying a strand does not cancel its pending tasks; they run to completion.
+ * If the pool's queue stays full past its launch_timeout_ms, the drain which can't be
+ * queued runs on the calling thread instead, thus pending tasks are never stranded.
+ */
+class strand {
+public:
+    explicit strand(thread_pool& pool, size_t batch_size = 64) :
+        state_(std::make_shared<_state_t>()) {
+        state_->owner = &pool;
+        state_->batch_size = std::max<size_t>(1, batch_size);
+    }
+
+    strand(const strand& other) = delete;
+    strand(strand&& other) noexcept = default;
+    strand& operator=(const strand& other) = delete;
+    strand& operator=(strand&& other) noexcept = default;
+
+public:
+    template <typename Fn_, typename... Args_>
+    decltype(auto) add_task(Fn_&& f, Args_... args);
+
+    size_t num_pending_task() const { return state_->num_pending.load(std::memory_order_relaxed); }
+    thread_pool& pool() const { return *state_->owner; }
+
+private:
+    struct _node_t {
+        thread_pool::task_function_type event;
+        std::atomic<_node_t*> next = nullptr;
+    };
+
+    //! @see https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+    struct _state_t {
+        thread_pool* owner = nullptr;
+        size_t batch_size = 1;
+
+        _node_t stub;
+        std::atomic<_node_t*> head = &stub; // producers push here
+        _node_t* tail = &stub;              // only touched by the drain task
+        std::atomic_size_t num_pending = 0;
+
+        ~_state_t() {
+            for (_node_t* node; (node = _pop());) { delete node; }
+        }
+
+        void _push(_node_t* node) noexcept {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            auto prev = head.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        // returns nullptr if the list is empty, or a producer is in the middle of _push().
+        _node_t* _pop() noexcept {
+            auto node = tail;
+            auto next = node->next.load(std::memory_order_acquire);
+
+            if (node == &stub) {
+                if (next == nullptr) { return nullptr; }
+                tail = node = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next) { return tail = next, node; }
+            if (node != head.load(std::memory_order_acquire)) { return nullptr; }
+
+            _push(&stub);
+            if ((next = node->next.load(std::memory_order_acquire))) { return tail = next, node; }
+            return nullptr;
+        }
+
+        void _schedule(std::shared_ptr<_state_t> self) {
+            owner->_enqueue_task({[self = std::move(self)] { self->_drain(self); }});
+        }
+
+        void _drain(std::shared_ptr<_state_t> const& self) {
+            for (;;) {
+                // only tasks counted at this moment are consumed, thus each of them is
+                //guaranteed to be pushed already, though its link may not be visible yet.
+                auto const num_drain = std::min(batch_size, num_pending.load(std::memory_order_acquire));
+
+                for (size_t i = 0; i < num_drain; ++i) {
+                    _node_t* node;
+                    while ((node = _pop()) == nullptr) { std::this_thread::yield(); }
+
+                    std::unique_ptr<_node_t> holder{node};
+                    auto event = std::move(node->event);
+                    holder.reset();
+
+                    event();
+                }
+
+                if (num_pending.fetch_sub(num_drain, std::memory_order_acq_rel) == num_drain) { return; }
+
+                // tasks were added during drain. re-queue at the back of the pool,
+                //to let other strands and tasks progress.
+                try {
+                    return _schedule(self);
+                } catch (thread_pool_exception&) {
+                    // queue of the pool stays full; keep draining here, as this is the only drain.
+                }
+            }
+        }
+    };
+
+private:
+    std::shared_ptr<_state_t> state_;
+};
+
+template <typename Fn_, typename... Args_>
+decltype(auto) strand::add_task(Fn_&& f, Args_... args) {
+    static_assert(std::is_invocable_v<Fn_, Args_...>);
+    using proxy_type = future_proxy<std::invoke_result_t<Fn_, Args_...>>;
+
+    auto node = std::make_unique<_node_t>();
+    auto result = std::make_shared<proxy_type>();
+    state_->owner->_package_task<Fn_, Args_...>(node->event, result, std::forward<Fn_>(f), std::forward<Args_>(args)...);
+
+    state_->_push(node.release());
+    if (state_->num_pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+        // this is the first pending task; no drain task is alive.
+        try {
+            state_->_schedule(state_);
+        } catch (thread_pool_exception&) {
+            // task is counted already, and later ones rely on this drain; run it here.
+            state_->_drain(state_);
+        }
+    }
+
+    return result;
+}
+} // namespace KANGSW_THREAD_POOL_ABI
+} // namespace kangsw
@@ -7,17 +7,41 @@
  * ----------------------------------------------------------------------------
  */
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
+#include <list>
 #include <map>
+#include <memory_resource>
 #include <mutex>
 #include <shared_mutex>
 #include <thread>
 #include <type_traits>
 #include "kangsw/thread/atomic_queue.hxx"
+#include "kangsw/thread/spinlock.hxx"
+
+#if KANGSW_THREAD_POOL_TRACE
+#include <array>
+#include <ostream>
+#include <string>
+#ifndef KANGSW_THREAD_POOL_TRACE_CAPACITY
+#define KANGSW_THREAD_POOL_TRACE_CAPACITY (1 << 14)
+#endif
+#endif
+
+// tracing changes layout of the pool, thus traced and untraced builds are kept in different
+//inline namespaces; translation units of either setting can be linked into one program.
+#if KANGSW_THREAD_POOL_TRACE
+#define KANGSW_THREAD_POOL_ABI traced
+#else
+#define KANGSW_THREAD_POOL_ABI untraced
+#endif
 
 namespace kangsw:: inline threads {
+inline namespace KANGSW_THREAD_POOL_ABI {
 class thread_pool_exception : public std::exception {
 public:
     explicit thread_pool_exception(char const* _Message)
@@ -88,6 +112,7 @@ class future_proxy<void> : public future_proxy_base {
 class thread_pool {
     template <typename Ty_>
     friend class future_proxy;
+    friend class blocking_section;
 
 public:
     using clock = std::chrono::system_clock;
@@ -96,6 +121,9 @@ public:
     struct task_t {
         task_function_type event;
         clock::time_point issued = clock::now();
+#if KANGSW_THREAD_POOL_TRACE
+        uint64_t trace_id = 0;
+#endif
     };
 
 public:
@@ -111,35 +139,138 @@ public:
     void resize_worker_pool(size_t new_size, bool is_trial = false);
     size_t num_workers() const { return num_workers_cached_; }
     size_t num_pending_task() const { return tasks_.size(); }
-    size_t task_queue_capacity() const { return tasks_.capacity(); }
+    size_t task_queue_capacity() const { return task_queue_capacity_; }
     size_t num_available_workers() const { return num_workers_cached_ - num_working_workers_; }
     clock::duration average_interval() const { return clock::duration(average_interval_.load()); }
     clock::duration average_wait() const { return clock::duration(true_average_wait_.load()); }
     clock::duration _internal_average_wait() const { return clock::duration(refreshed_average_wait_.load()); }
     size_t num_max_workers() const { return num_max_workers_; }
     void num_max_workers(size_t value);
+    size_t num_blocked_workers() const { return num_blocked_workers_; }
+    size_t num_blocking_workers() const { return num_blocking_workers_; }
+
+    /**
+     * Memory resource for task-local scratch allocations.
+     * Inside a task, returns the calling worker's monotonic arena, which is released
+     * after every task; thus anything allocated from it must not outlive the task.
+     * Outside of pool workers, returns std::pmr::get_default_resource().
+     */
+    static std::pmr::memory_resource* task_memory_resource() noexcept {
+        return _this_worker ? &_this_worker->arena : std::pmr::get_default_resource();
+    }
+
+#if KANGSW_THREAD_POOL_TRACE
+    /**
+     * Dumps recorded scheduling events in Chrome trace JSON format, which can be
+     * loaded from chrome://tracing or Perfetto.
+     * Each worker keeps only the latest KANGSW_THREAD_POOL_TRACE_CAPACITY events.
+     * Events recorded while dumping may appear torn; dump on a quiescent pool.
+     */
+    void dump_trace(std::ostream& os) const;
+#endif
 
     template <typename Fn_, typename... Args_>
     decltype(auto) add_task(Fn_&& f, Args_... args);
 
+    /**
+     * Adds a task which may block on I/O or locks.
+     * Blocking tasks run on a separate elastic group of threads, which are spawned on
+     * demand up to 'max_blocking_workers', and retire after idle for 'blocking_worker_keep_alive'.
+     * Therefore they never occupy compute workers.
+     */
+    template <typename Fn_, typename... Args_>
+    decltype(auto) add_blocking_task(Fn_&& f, Args_... args);
+
+    /**
+     * Splits [first, last) into num_chunks contiguous ranges, and submits each as a task
+     * which invokes fn on its elements. fn may also take chunk index as second argument.
+     * Random access iterators, e.g. tiles() or iota, are split without walking over them.
+     * Returned future becomes ready when every chunk finishes, or holds the first exception.
+     * num_chunks of 0 means num_workers().
+     */
+    template <typename It_, typename Fn_>
+    std::shared_future<void> add_bulk_task(It_ first, It_ last, Fn_&& fn, size_t num_chunks = 0);
+
 public:
     template <typename Fn_, typename... Args_> void _package_task(
       thread_pool::task_function_type& event, std::shared_ptr<future_proxy_base> retval, Fn_&& f, Args_... args);
     void _enqueue_task(task_t&& task);
 
+private:
+    enum class _trace_t : uint8_t {
+        enqueue,
+        dequeue,
+        steal,
+        start,
+        finish,
+    };
+
+    void _trace(_trace_t type, task_t& task);
+
 private:
     bool _try_add_worker();
     void _pop_workers(size_t count);
-    void _check_reserve_worker(size_t threshold);
+    void _adjust_compute_slots();
+    bool _try_add_blocking_worker();
 
 public:
+    // stall thresholds are only observed; compute workers never grow by them, since
+    //blocked tasks hand their slots over in blocking_section instead.
     std::chrono::milliseconds launch_timeout_ms{1000};
     std::chrono::microseconds max_stall_interval_time{1000000};
     std::chrono::microseconds max_task_interval_time{1000000};
     std::chrono::microseconds max_task_wait_time{1000000};
     std::atomic_size_t average_weight = 10;
+    size_t task_arena_size = 64 << 10; // applied to workers created afterwards
+
+    // each worker pulls up to 'max_batch_size' tasks at once from the shared queue, so that
+    //a batch takes about 'batch_target_duration' by its observed average task duration.
+    std::atomic_size_t max_batch_size = 32;
+    std::chrono::microseconds batch_target_duration{200};
+
+    size_t max_blocking_workers = 256;
+    std::chrono::milliseconds blocking_worker_keep_alive{10000};
 
 private:
+#if KANGSW_THREAD_POOL_TRACE
+    // lock-free ring which keeps latest events; writers never block.
+    // each record is a seqlock, of which fields are atomic since external ring has many writers.
+    struct trace_ring_t {
+        struct record_t {
+            std::atomic_uint64_t seq = 0;
+            std::atomic_int64_t timestamp = 0;
+            std::atomic_uint64_t task_id = 0;
+            std::atomic<_trace_t> type = {};
+        };
+
+        void push(_trace_t type, uint64_t task_id) noexcept {
+            auto idx = cursor.fetch_add(1, std::memory_order_relaxed);
+            auto& r = records[idx % records.size()];
+            r.seq.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            r.timestamp.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            r.task_id.store(task_id, std::memory_order_relaxed);
+            r.type.store(type, std::memory_order_relaxed);
+            r.seq.store(idx + 1, std::memory_order_release);
+        }
+
+        // copies the record of idx, or returns false if it is overwritten or being written.
+        bool read(uint64_t idx, int64_t& timestamp, uint64_t& task_id, _trace_t& type) const noexcept {
+            auto& r = records[idx % records.size()];
+            if (r.seq.load(std::memory_order_acquire) != idx + 1) { return false; }
+
+            timestamp = r.timestamp.load(std::memory_order_relaxed);
+            task_id = r.task_id.load(std::memory_order_relaxed);
+            type = r.type.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return r.seq.load(std::memory_order_relaxed) == idx + 1;
+        }
+
+        std::atomic_uint64_t cursor = 0;
+        std::array<record_t, KANGSW_THREAD_POOL_TRACE_CAPACITY> records;
+    };
+#endif
+
     struct worker_t {
         struct atomic_bool_wrap_t {
             std::atomic_bool value;
@@ -155,12 +286,61 @@ private:
                 return *this;
             }
         };
+        // worker-owned states, which require stable address.
+        struct local_t {
+            explicit local_t(thread_pool* owner, size_t arena_size) :
+                owner(owner),
+                arena_buffer(new std::byte[std::max<size_t>(1, arena_size)]),
+                arena(arena_buffer.get(), std::max<size_t>(1, arena_size)) {}
+
+            thread_pool* owner;
+            std::unique_ptr<std::byte[]> arena_buffer;
+            std::pmr::monotonic_buffer_resource arena;
+
+            // tasks fetched ahead from shared queue, which idle peers can steal from back.
+            spinlock batch_lock;
+            std::deque<task_t> batch;
+            std::vector<task_t> fetch_buffer;
+            int64_t average_exec = 0; // in clock ticks, only touched by owner
+
+            // only the worker holding compute slot can execute tasks. see blocking_section
+            bool has_compute_slot = false;
+            std::atomic_bool disposed = false;
+
+            // spare worker retires at its next loop, unless revived by a new blocked worker before.
+            enum class state_t : uint8_t { active, retiring, exited };
+            std::atomic<state_t> state = state_t::active;
+#if KANGSW_THREAD_POOL_TRACE
+            std::unique_ptr<trace_ring_t> trace = std::make_unique<trace_ring_t>();
+#endif
+        };
+
         std::thread thread;
         atomic_bool_wrap_t disposer;
+        std::unique_ptr<local_t> local;
+    };
+
+    struct blocking_worker_t {
+        std::thread thread;
+        bool retired = false; // guarded by blocking_lock_
     };
 
+    bool _acquire_compute_slot(bool demanded);
+    void _release_compute_slot(worker_t::local_t& local);
+    void _enter_blocking(worker_t::local_t& local);
+    void _leave_blocking(worker_t::local_t& local);
+    void _retire_spare_worker(worker_t::local_t const& caller);
+    bool _revive_spare_worker();
+    void _reap_workers();
+
+    bool _pop_batch(worker_t::local_t& local, task_t& task);
+    bool _fetch_batch(worker_t::local_t& local, task_t& task);
+    bool _steal_batch(worker_t::local_t& local, task_t& task);
+
 private:
     atomic_queue<task_t> tasks_;
+    size_t task_queue_capacity_;
+    std::atomic_size_t num_batched_tasks_ = 0; // sum of every worker's batch size
     std::vector<worker_t> workers_;
     mutable std::shared_mutex worker_lock_;
 
@@ -177,6 +357,34 @@ private:
     std::atomic<int64_t> average_interval_;
     std::atomic<int64_t> refreshed_average_wait_;
     std::atomic<int64_t> true_average_wait_;
+
+    // compute concurrency is limited by number of slots, regardless of number of threads.
+    //spare workers, which take over slots of blocked workers, are guarded by worker_lock_.
+    std::atomic<ptrdiff_t> free_compute_slots_ = 0;
+    ptrdiff_t num_compute_slots_ = 0;
+    size_t num_compute_workers_ = 0; // configured by resize_worker_pool
+    size_t num_spare_workers_ = 0;
+    std::atomic_size_t num_exited_workers_ = 0; // retired, but not joined yet
+    std::atomic_size_t num_blocked_workers_ = 0;
+    std::atomic_size_t num_slot_demands_ = 0;
+    std::condition_variable slot_wait_;
+    std::mutex slot_lock_;
+
+    atomic_queue<task_t> blocking_tasks_{1024};
+    std::list<blocking_worker_t> blocking_workers_;
+    std::condition_variable blocking_wait_;
+    std::mutex blocking_lock_;
+    size_t num_idle_blocking_workers_ = 0;
+    size_t num_blocking_wakeups_ = 0;
+    bool blocking_disposed_ = false;
+    std::atomic_size_t num_blocking_workers_ = 0;
+
+#if KANGSW_THREAD_POOL_TRACE
+    trace_ring_t external_trace_; // events from non-worker threads
+    std::atomic_uint64_t trace_id_gen_ = 0;
+#endif
+
+    static inline thread_local worker_t::local_t* _this_worker = nullptr;
 };
 
 template <typename Fn_, typename... Args_>
@@ -242,21 +450,84 @@ void thread_pool::_package_task(task_function_type& event, std::shared_ptr<futur
     }
 }
 
+inline void thread_pool::_trace([[maybe_unused]] _trace_t type, [[maybe_unused]] task_t& task) {
+#if KANGSW_THREAD_POOL_TRACE
+    if (type == _trace_t::enqueue) {
+        task.trace_id = trace_id_gen_.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    auto& ring = _this_worker && _this_worker->owner == this ? *_this_worker->trace : external_trace_;
+    ring.push(type, task.trace_id);
+#endif
+}
+
+#if KANGSW_THREAD_POOL_TRACE
+inline void thread_pool::dump_trace(std::ostream& os) const {
+    static constexpr char const* names[] = {"enqueue", "dequeue", "steal", "task", "task"};
+    auto const flags = os.flags();
+    bool first = true;
+
+    auto dump_ring = [&](trace_ring_t const& ring, size_t tid) {
+        os << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << tid
+           << R"(,"args":{"name":")" << (tid ? "worker " + std::to_string(tid - 1) : "external") << R"("}})";
+        first = false;
+
+        auto const end = ring.cursor.load(std::memory_order_acquire);
+        auto const begin = end > ring.records.size() ? end - ring.records.size() : 0;
+
+        for (auto idx = begin; idx < end; ++idx) {
+            int64_t timestamp;
+            uint64_t task_id;
+            _trace_t type;
+            if (!ring.read(idx, timestamp, task_id, type)) { continue; }
+
+            auto const ts = std::chrono::duration<double, std::micro>(clock::duration(timestamp)).count();
+            os << std::fixed << ",\n{\"name\":\"" << names[size_t(type)] << R"(","cat":"thread_pool","pid":0,"tid":)" << tid
+               << R"(,"ts":)" << ts << R"(,"args":{"task":)" << task_id << "}";
+
+            switch (type) {
+                case _trace_t::start: os << R"(,"ph":"B"},)"
+                                         << R"({"name":"task","cat":"thread_pool","ph":"f","bp":"e","pid":0,"tid":)" << tid
+                                         << R"(,"ts":)" << ts << R"(,"id":)" << task_id << "}";
+                    break;
+                case _trace_t::finish: os << R"(,"ph":"E"})"; break;
+                case _trace_t::enqueue: os << R"(,"ph":"i","s":"t"},)"
+                                           << R"({"name":"task","cat":"thread_pool","ph":"s","pid":0,"tid":)" << tid
+                                           << R"(,"ts":)" << ts << R"(,"id":)" << task_id << "}";
+                    break;
+                default: os << R"(,"ph":"i","s":"t"})"; break;
+            }
+        }
+    };
+
+    os << "{\"traceEvents\":[\n";
+    dump_ring(external_trace_, 0);
+
+    std::shared_lock lock{worker_lock_};
+    for (size_t i = 0; i < workers_.size(); ++i) { dump_ring(*workers_[i].local->trace, i + 1); }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    os.flags(flags);
+}
+#endif
+
 inline void thread_pool::_enqueue_task(task_t&& task) {
     if (num_pending_task() == 0) {
         latest_event_ = clock::now();
     }
 
+    _trace(_trace_t::enqueue, task);
+
+    // the queue itself is unbounded, thus capacity is checked here; racing producers may
+    //exceed it slightly, which is harmless.
     for (
       auto elapse_begin = clock::now();
-      !tasks_.try_push(std::move(task));
+      !(tasks_.size() < task_queue_capacity_ && tasks_.try_push(std::move(task)));
       std::this_thread::yield()) {
         if (clock::now() - elapse_begin > launch_timeout_ms) {
             throw thread_pool_exception{""};
         }
     }
 
-    _check_reserve_worker(1);
     event_wait_.notify_one();
 }
 template <typename Fn_, typename... Args_>
@@ -275,13 +546,88 @@ decltype(auto) thread_pool::add_task(Fn_&& f, Args_... args) {
     return result;
 }
 
+template <typename Fn_, typename... Args_>
+decltype(auto) thread_pool::add_blocking_task(Fn_&& f, Args_... args) {
+    static_assert(std::is_invocable_v<Fn_, Args_...>);
+    using proxy_type = future_proxy<std::invoke_result_t<Fn_, Args_...>>;
+
+    task_t task;
+    auto result = std::make_shared<proxy_type>();
+    _package_task<Fn_, Args_...>(task.event, result, std::forward<Fn_>(f), std::forward<Args_>(args)...);
+    blocking_tasks_.try_push(std::move(task));
+
+    if (std::unique_lock lock{blocking_lock_}; lock) {
+        if (num_idle_blocking_workers_ > num_blocking_wakeups_) {
+            ++num_blocking_wakeups_;
+            blocking_wait_.notify_one();
+        }
+        else {
+            // if every blocking worker is busy and the group is at its limit,
+            //the task is picked up by the first worker which finishes its task.
+            _try_add_blocking_worker();
+        }
+    }
+
+    return result;
+}
+
+template <typename It_, typename Fn_>
+std::shared_future<void> thread_pool::add_bulk_task(It_ first, It_ last, Fn_&& fn, size_t num_chunks) {
+    struct state_t {
+        std::decay_t<Fn_> fn;
+        std::atomic_size_t num_remaining;
+        std::atomic_flag failed;
+        std::exception_ptr error;
+        std::promise<void> done;
+    };
+
+    size_t const num_elems = std::distance(first, last);
+    num_chunks = std::min(num_elems, num_chunks ? num_chunks : std::max<size_t>(1, num_workers()));
+
+    auto state = std::make_shared<state_t>(std::forward<Fn_>(fn), num_chunks);
+    std::shared_future<void> result = state->done.get_future().share();
+    if (num_chunks == 0) { return state->done.set_value(), result; }
+
+    for (size_t chunk = 0, begin = 0; chunk < num_chunks; ++chunk) {
+        auto const end = num_elems * (chunk + 1) / num_chunks;
+
+        add_task([state, chunk, it = std::next(first, begin), n = end - begin]() mutable {
+            try {
+                for (size_t i = 0; i < n; ++i, ++it) {
+                    if constexpr (std::is_invocable_v<decltype(state->fn), decltype(*it), size_t>) { state->fn(*it, chunk); }
+                    else { state->fn(*it); }
+                }
+            } catch (...) {
+                if (!state->failed.test_and_set()) { state->error = std::current_exception(); }
+            }
+
+            if (state->num_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                state->error ? state->done.set_exception(state->error) : state->done.set_value();
+            }
+        });
+
+        begin = end;
+    }
+
+    return result;
+}
+
 inline thread_pool::thread_pool(size_t task_queue_cap_, size_t num_workers, size_t worker_limit) noexcept
     : tasks_(task_queue_cap_)
+    , task_queue_capacity_(std::max<size_t>(1, task_queue_cap_))
     , num_max_workers_(worker_limit) {
     resize_worker_pool(num_workers, false);
 }
 
 inline thread_pool::~thread_pool() {
+    if (std::unique_lock lock{blocking_lock_}; lock) {
+        blocking_disposed_ = true;
+        blocking_wait_.notify_all();
+    }
+    for (auto& blocking_worker : blocking_workers_) {
+        blocking_worker.thread.join();
+    }
+
     _pop_workers(workers_.size());
 }
 
@@ -291,8 +637,14 @@ inline void thread_pool::resize_worker_pool(size_t new_size, bool is_trial) {
         throw std::invalid_argument{"Size 0 is not allowed"};
     }
 
+    // workers look up their peers under shared lock to steal tasks, thus the worker
+    //list can't be modified without lock.
     std::unique_lock lock(worker_lock_, std::defer_lock);
-    if (!is_trial || lock.try_lock()) {
+    if (is_trial ? lock.try_lock() : (lock.lock(), true)) {
+        _reap_workers();
+        _revive_spare_worker();
+        num_compute_workers_ = new_size;
+
         if (new_size > workers_.size()) {
             while (new_size != workers_.size()) {
                 _try_add_worker();
@@ -301,6 +653,8 @@ inline void thread_pool::resize_worker_pool(size_t new_size, bool is_trial) {
         else if (new_size < workers_.size()) {
             _pop_workers(workers_.size() - new_size);
         }
+
+        _adjust_compute_slots();
     }
 
     latest_worker_change_ = clock::now();
@@ -311,64 +665,290 @@ inline void thread_pool::num_max_workers(size_t value) {
         throw std::invalid_argument("0 is not allowed");
     }
 
-    std::shared_lock lock{worker_lock_};
+    std::unique_lock lock{worker_lock_};
     num_max_workers_ = value;
 
     if (value < workers_.size()) {
         _pop_workers(workers_.size() - value);
+        _adjust_compute_slots();
     }
 }
 
-inline bool thread_pool::_try_add_worker() {
-    static auto constexpr RELAXED = std::memory_order_relaxed;
-    if (workers_.size() >= num_max_workers_) {
+inline void thread_pool::_adjust_compute_slots() {
+    num_spare_workers_ = std::min(num_spare_workers_, workers_.size());
+    auto const num_slots = static_cast<ptrdiff_t>(std::min(num_compute_workers_, workers_.size() - num_spare_workers_));
+
+    // slots held by removed workers are returned on their exit.
+    free_compute_slots_.fetch_add(num_slots - num_compute_slots_);
+    num_compute_slots_ = num_slots;
+}
+
+inline bool thread_pool::_acquire_compute_slot(bool demanded) {
+    auto num_free = free_compute_slots_.load();
+    while (num_free > 0 && (demanded || num_slot_demands_.load() == 0)) {
+        if (free_compute_slots_.compare_exchange_weak(num_free, num_free - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void thread_pool::_release_compute_slot(worker_t::local_t& local) {
+    local.has_compute_slot = false;
+    free_compute_slots_.fetch_add(1);
+
+    if (num_slot_demands_.load() > 0) {
+        slot_wait_.notify_all();
+    }
+}
+
+inline void thread_pool::_enter_blocking(worker_t::local_t& local) {
+    num_blocked_workers_.fetch_add(1);
+    num_working_workers_.fetch_sub(1);
+    _release_compute_slot(local);
+
+    // if there are less unblocked workers than slots, spawn a spare worker to take over.
+    //never wait for the lock here, since the owner of lock may be joining this thread.
+    if (std::unique_lock lock{worker_lock_, std::try_to_lock}; lock) {
+        _reap_workers();
+
+        auto const num_unblocked = ptrdiff_t(workers_.size()) - ptrdiff_t(num_blocked_workers_.load());
+        if (num_unblocked < num_compute_slots_ && !_revive_spare_worker()) {
+            try {
+                num_spare_workers_ += _try_add_worker();
+            } catch (...) {
+                // failed to launch a thread; blocked slot is left vacant until the section ends.
+            }
+        }
+    }
+
+    event_wait_.notify_one();
+}
+
+inline void thread_pool::_leave_blocking(worker_t::local_t& local) {
+    // running workers yield their slots at next task boundary while demand exists.
+    num_slot_demands_.fetch_add(1);
+    while (!(local.has_compute_slot = _acquire_compute_slot(true)) && !local.disposed) {
+        std::unique_lock lock{slot_lock_};
+        slot_wait_.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    num_slot_demands_.fetch_sub(1);
+
+    num_working_workers_.fetch_add(1);
+    num_blocked_workers_.fetch_sub(1);
+
+    if (std::unique_lock lock{worker_lock_, std::try_to_lock}; lock) {
+        _retire_spare_worker(local);
+    }
+
+    if (free_compute_slots_.load() > 0 && !tasks_.empty()) {
+        // other workers might have been rejected while the demand existed
+        event_wait_.notify_one();
+    }
+}
+
+inline void thread_pool::_retire_spare_worker(worker_t::local_t const& caller) {
+    // spare workers are the latest ones, thus retire from the back.
+    if (num_spare_workers_ == 0 || workers_.empty()) { return; }
+    auto& last = *workers_.back().local;
+    if (&last == &caller || last.state.load() != worker_t::local_t::state_t::active) { return; }
+
+    auto const num_unblocked = ptrdiff_t(workers_.size()) - ptrdiff_t(num_blocked_workers_.load());
+    if (num_unblocked <= num_compute_slots_) { return; }
+
+    last.state.store(worker_t::local_t::state_t::retiring);
+    std::lock_guard lock{event_lock_};
+    event_wait_.notify_all();
+}
+
+inline bool thread_pool::_revive_spare_worker() {
+    if (workers_.empty()) { return false; }
+    auto expected = worker_t::local_t::state_t::retiring;
+    return workers_.back().local->state.compare_exchange_strong(expected, worker_t::local_t::state_t::active);
+}
+
+inline void thread_pool::_reap_workers() {
+    if (num_exited_workers_.load() == 0) { return; }
+
+    while (!workers_.empty() && workers_.back().local->state.load() == worker_t::local_t::state_t::exited) {
+        workers_.back().thread.join();
+        workers_.pop_back();
+        num_exited_workers_.fetch_sub(1);
+        num_spare_workers_ -= num_spare_workers_ > 0;
+    }
+
+    num_workers_cached_ = workers_.size();
+    _adjust_compute_slots();
+}
+
+inline bool thread_pool::_try_add_blocking_worker() {
+    // reap retired workers first
+    for (auto it = blocking_workers_.begin(); it != blocking_workers_.end();) {
+        if (it->retired) {
+            it->thread.join();
+            it = blocking_workers_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if (num_blocking_workers_ >= max_blocking_workers) {
         return false;
     }
 
-    auto worker = [this, index = workers_.size()]() {
+    auto& wd = blocking_workers_.emplace_back();
+    num_blocking_workers_.fetch_add(1);
+
+    wd.thread = std::thread([this, &wd]() {
         task_t task;
+        std::unique_lock lock{blocking_lock_};
 
-        auto calc_diff = [this](clock::time_point issued, size_t average, size_t weight) {
-            auto wait_time = (clock::now() - issued).count();
-            auto new_average = ((average * (weight - 1)) + wait_time) / weight;
-            auto diff = new_average - average;
+        while (!blocking_disposed_) {
+            lock.unlock();
+            if (blocking_tasks_.try_pop(task)) {
+                task.event();
+                task = {};
+                lock.lock();
+                continue;
+            }
 
-            return diff;
-        };
+            // tasks are pushed before lock is taken by producers, thus checking the
+            //queue under lock can't miss any notification.
+            lock.lock();
+            if (!blocking_tasks_.empty()) { continue; }
 
-        while (workers_[index].disposer.value == false) {
-            if (tasks_.try_pop(task)) {
-                auto weight = std::max<size_t>(1, average_weight.load(RELAXED));
+            ++num_idle_blocking_workers_;
+            auto awaken = blocking_wait_.wait_for(
+              lock, blocking_worker_keep_alive,
+              [this] { return num_blocking_wakeups_ > 0 || blocking_disposed_; });
+            --num_idle_blocking_workers_;
+
+            if (!awaken) { break; }
+            if (num_blocking_wakeups_ > 0) { --num_blocking_wakeups_; }
+        }
+
+        wd.retired = true;
+        num_blocking_workers_.fetch_sub(1);
+    });
+
+    return true;
+}
+
+inline bool thread_pool::_try_add_worker() {
+    if (workers_.size() >= num_max_workers_) {
+        return false;
+    }
+
+    auto& wd = workers_.emplace_back();
+    wd.disposer.value = false;
+    try {
+        wd.local = std::make_unique<worker_t::local_t>(this, task_arena_size);
+    } catch (...) {
+        workers_.pop_back();
+        throw;
+    }
+    wd.local->average_exec = clock::duration(batch_target_duration).count();
 
-                auto issued = latest_event_.load(RELAXED);
-                auto average = average_interval_.load(RELAXED);
-                average_interval_.fetch_add(calc_diff(issued, average, weight), RELAXED);
+    auto worker = [this, index = workers_.size() - 1, local = wd.local.get()]() {
+        task_t task;
+        bool working = false;
+        _this_worker = local;
 
-                issued = std::max(task.issued, latest_worker_change_.load());
-                average = refreshed_average_wait_.load(RELAXED);
-                refreshed_average_wait_.fetch_add(calc_diff(issued, average, weight), RELAXED);
+        while (workers_[index].disposer.value == false) {
+            if (auto expected = worker_t::local_t::state_t::retiring;
+                local->state.compare_exchange_strong(expected, worker_t::local_t::state_t::exited)) {
+                break;
+            }
 
-                true_average_wait_.fetch_add(calc_diff(task.issued, true_average_wait_.load(RELAXED), weight), RELAXED);
+            if (!local->has_compute_slot && !(local->has_compute_slot = _acquire_compute_slot(false))) {
+                // all slots are occupied; park until any slot is released.
+                std::unique_lock<std::mutex> lock(event_lock_);
+                if (workers_[index].disposer.value == false) {
+                    event_wait_.wait(lock);
+                }
+                continue;
+            }
 
-                _check_reserve_worker(2);
-                latest_active_ = clock::now();
-                latest_event_ = clock::now();
-                num_working_workers_.fetch_add(1);
+            if (_pop_batch(*local, task) || _fetch_batch(*local, task) || _steal_batch(*local, task)) {
+                if (!working) {
+                    num_working_workers_.fetch_add(1);
+                    working = true;
+                }
 
+                _trace(_trace_t::start, task);
+                auto exec_begin = clock::now();
                 task.event();
+                auto exec_time = (clock::now() - exec_begin).count();
+                _trace(_trace_t::finish, task);
+                local->arena.release();
+
+                auto weight = std::max<int64_t>(1, average_weight.load(std::memory_order_relaxed));
+                local->average_exec += (exec_time - local->average_exec) / weight;
 
-                num_working_workers_.fetch_sub(1);
+                if (local->has_compute_slot && num_slot_demands_.load(std::memory_order_relaxed) > 0) {
+                    // a worker returned from blocking_section is waiting for its slot.
+                    _release_compute_slot(*local);
+                }
             }
             else {
+                if (working) {
+                    num_working_workers_.fetch_sub(1);
+                    working = false;
+                }
+
+                // idle workers don't occupy slots
+                if (local->has_compute_slot) {
+                    _release_compute_slot(*local);
+                }
+
+                if (num_exited_workers_.load() > 0) {
+                    if (std::unique_lock lock{worker_lock_, std::try_to_lock}; lock) { _reap_workers(); }
+                }
+
+                if (num_batched_tasks_.load() > 0 || !tasks_.empty()) {
+                    // tasks are left, which were missed only by lock contention; retry.
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                // batches are filled before peers are notified under this lock, thus re-checking
+                //here can't miss them. wakeups of enqueue may be missed, which the timeout covers.
                 std::unique_lock<std::mutex> lock(event_lock_);
-                event_wait_.wait(lock);
+                if (workers_[index].disposer.value == false && num_batched_tasks_.load() == 0 && tasks_.empty()) {
+                    event_wait_.wait_for(lock, std::chrono::milliseconds(10));
+                }
             }
         }
+
+        if (working) {
+            num_working_workers_.fetch_sub(1);
+        }
+        if (local->has_compute_slot) {
+            _release_compute_slot(*local);
+        }
+
+        // hand over fetched but not executed tasks to remaining workers.
+        if (std::lock_guard lock{local->batch_lock}; true) {
+            for (auto& remaining : local->batch) { tasks_.try_push(std::move(remaining)); }
+            num_batched_tasks_.fetch_sub(local->batch.size());
+            local->batch.clear();
+        }
+
+        if (local->state.load() == worker_t::local_t::state_t::exited) {
+            // let an idle peer join this thread
+            num_exited_workers_.fetch_add(1);
+            std::lock_guard lock{event_lock_};
+            event_wait_.notify_one();
+        }
     };
 
-    auto& wd = workers_.emplace_back();
-    wd.disposer.value = false;
-    wd.thread = std::thread(std::move(worker));
+    try {
+        wd.thread = std::thread(std::move(worker));
+    } catch (...) {
+        workers_.pop_back();
+        throw;
+    }
 
     num_workers_cached_ = workers_.size();
     return true;
@@ -380,24 +960,145 @@ inline void thread_pool::_pop_workers(size_t count) {
 
     for (auto it = begin; it != end; ++it) {
         it->disposer.value.store(true);
+        it->local->disposed.store(true);
+    }
+    if (std::unique_lock lock{event_lock_}; lock) {
+        // workers check disposer under this lock before wait
+        event_wait_.notify_all();
     }
-    event_wait_.notify_all();
     for (auto it = begin; it != end; ++it) {
         it->thread.join();
+
+        // retired spare workers, which are joined here instead
+        if (it->local->state.load() != worker_t::local_t::state_t::active) {
+            num_spare_workers_ -= num_spare_workers_ > 0;
+            num_exited_workers_.fetch_sub(it->local->state.load() == worker_t::local_t::state_t::exited);
+        }
     }
 
     workers_.erase(begin, end);
     num_workers_cached_ = workers_.size();
+
+    if (!tasks_.empty()) {
+        event_wait_.notify_all();
+    }
+}
+
+inline bool thread_pool::_pop_batch(worker_t::local_t& local, task_t& task) {
+    std::lock_guard lock{local.batch_lock};
+    if (local.batch.empty()) {
+        return false;
+    }
+
+    task = std::move(local.batch.front());
+    local.batch.pop_front();
+    num_batched_tasks_.fetch_sub(1);
+    return true;
+}
+
+inline bool thread_pool::_fetch_batch(worker_t::local_t& local, task_t& task) {
+    static auto constexpr RELAXED = std::memory_order_relaxed;
+
+    auto const target = clock::duration(batch_target_duration).count();
+    auto const num_fetch = local.average_exec > 0
+                             ? std::clamp<size_t>(target / local.average_exec, 1, std::max<size_t>(1, max_batch_size.load(RELAXED)))
+                             : std::max<size_t>(1, max_batch_size.load(RELAXED));
+
+    auto& fetched = local.fetch_buffer;
+    fetched.clear();
+    if (tasks_.try_pop_n(std::back_inserter(fetched), num_fetch) == 0) {
+        return false;
+    }
+
+    // statistics are accumulated locally, then applied once per batch.
+    auto const weight = std::max<int64_t>(1, average_weight.load(RELAXED));
+    auto const now = clock::now();
+    auto ewma = [weight](int64_t average, clock::duration sample) {
+        return average + (sample.count() - average) / weight;
+    };
+
+    auto interval = average_interval_.load(RELAXED);
+    average_interval_.fetch_add(ewma(interval, now - latest_event_.load(RELAXED)) - interval, RELAXED);
+
+    auto const refreshed = refreshed_average_wait_.load(RELAXED);
+    auto const truth = true_average_wait_.load(RELAXED);
+    auto const worker_change = latest_worker_change_.load();
+    auto new_refreshed = refreshed, new_truth = truth;
+
+    for (auto& fetched_task : fetched) {
+        _trace(_trace_t::dequeue, fetched_task);
+        new_refreshed = ewma(new_refreshed, now - std::max(fetched_task.issued, worker_change));
+        new_truth = ewma(new_truth, now - fetched_task.issued);
+    }
+
+    refreshed_average_wait_.fetch_add(new_refreshed - refreshed, RELAXED);
+    true_average_wait_.fetch_add(new_truth - truth, RELAXED);
+
+    latest_active_ = now;
+    latest_event_ = now;
+
+    task = std::move(fetched.front());
+    if (fetched.size() > 1) {
+        if (std::lock_guard lock{local.batch_lock}; true) {
+            std::move(fetched.begin() + 1, fetched.end(), std::back_inserter(local.batch));
+            num_batched_tasks_.fetch_add(fetched.size() - 1);
+        }
+
+        // let idle peers steal from fetched batch
+        std::lock_guard lock{event_lock_};
+        event_wait_.notify_one();
+    }
+
+    fetched.clear();
+    return true;
 }
 
-inline void thread_pool::_check_reserve_worker(size_t threshold) {
-    if ( // reserve workers if required.
-      num_available_workers() <= threshold
-      && (clock::now() - latest_active_.load() > max_stall_interval_time
-          || average_interval() > max_task_interval_time
-          || _internal_average_wait() > max_task_wait_time)) {
-        resize_worker_pool((num_workers() & ~1) + 2, true);
+inline bool thread_pool::_steal_batch(worker_t::local_t& local, task_t& task) {
+    std::shared_lock lock{worker_lock_, std::try_to_lock};
+    if (!lock) {
+        return false;
+    }
+
+    // start from different victim for each worker, to spread contention
+    auto const num_peers = workers_.size();
+    auto const offset = reinterpret_cast<uintptr_t>(&local) / sizeof(local);
+
+    auto& stolen = local.fetch_buffer;
+    stolen.clear();
+
+    for (size_t i = 0; i < num_peers && stolen.empty(); ++i) {
+        auto& victim = *workers_[(offset + i) % num_peers].local;
+        if (&victim == &local) { continue; }
+
+        // takes back half of victim's batch. never lock own batch while holding victim's.
+        if (std::unique_lock victim_lock{victim.batch_lock, std::try_to_lock}; victim_lock) {
+            auto const steal_begin = victim.batch.end() - (victim.batch.size() + 1) / 2;
+            std::move(steal_begin, victim.batch.end(), std::back_inserter(stolen));
+            victim.batch.erase(steal_begin, victim.batch.end());
+            num_batched_tasks_.fetch_sub(stolen.size());
+        }
+    }
+
+    if (stolen.empty()) {
+        return false;
     }
+
+    task = std::move(stolen.front());
+    _trace(_trace_t::steal, task);
+
+    if (stolen.size() > 1) {
+        if (std::lock_guard local_lock{local.batch_lock}; true) {
+            std::move(stolen.begin() + 1, stolen.end(), std::back_inserter(local.batch));
+            num_batched_tasks_.fetch_add(stolen.size() - 1);
+        }
+
+        // rest of the stolen batch can be stolen again by another idle peer
+        std::lock_guard lock{event_lock_};
+        event_wait_.notify_one();
+    }
+
+    stolen.clear();
+    return true;
 }
 
 template <typename Ty_> template <typename Fn_, typename... Args_>
@@ -463,6 +1164,39 @@ future_proxy<Ty_>::then(Fn_&& f, Args_&&... args) {
     return deferred;
 }
 
+/**
+ * Scope which marks calling pool worker as blocked, e.g. waiting for file I/O or lock.
+ *
+ * While blocked, the worker hands its compute slot over to another worker, spawning a
+ * spare worker if required, so that number of workers running compute tasks stays the same.
+ * On exit, waits until the slot is given back, which happens at the next task boundary of
+ * any running worker, and the spare worker retires if no longer required.
+ * Does nothing if the calling thread is not a compute worker, or already blocked.
+ * Never throws; if a spare worker can't be launched, the slot stays vacant meanwhile.
+ */
+class blocking_section {
+public:
+    blocking_section() noexcept :
+        local_(thread_pool::_this_worker) {
+        if (local_ && local_->has_compute_slot) {
+            local_->owner->_enter_blocking(*local_);
+        }
+        else {
+            local_ = nullptr;
+        }
+    }
+
+    ~blocking_section() {
+        if (local_) { local_->owner->_leave_blocking(*local_); }
+    }
+
+    blocking_section(const blocking_section& other) = delete;
+    blocking_section& operator=(const blocking_section& other) = delete;
+
+private:
+    thread_pool::worker_t::local_t* local_;
+};
+
 // timer thread pool
 class timer_thread_pool : public thread_pool {
 public:
@@ -553,4 +1287,5 @@ private:
     mutable std::mutex timer_lock_;
 };
 
+} // namespace KANGSW_THREAD_POOL_ABI
 } // namespace kangsw
@@ -1,3 +1,5 @@
+#include <numeric>
+#include <random>
 #include <kangsw/algorithm/hungarian.hxx>
 #include "catch.hpp"
 
@@ -18,5 +20,295 @@ TEST_CASE("Hungarian", "[Algorithms]") {
                 13, 13, 11, 12});
 
     assignment = kangsw::algorithm::hungarian(std::move(arr));
-    REQUIRE(std::ranges::equal(assignment, std::initializer_list{0, 3, 1, 2}));
+    REQUIRE(std::ranges::equal(assignment, std::initializer_list{1, 3, 0, 2}));
+}
+
+TEST_CASE("Hungarian sparse", "[Algorithms]") {
+    kangsw::sparse_builder<int> builder(3, 3);
+    builder.append(std::vector<std::tuple<int, int, int>>{{0, 0, 3}, {0, 1, 8}, {1, 0, 4}, {1, 2, 7}, {2, 1, 8}, {2, 2, 5}});
+
+    // (1, 1) and the rest are absent, thus prohibitively expensive
+    auto assignment = kangsw::algorithm::hungarian(builder.build(), 100);
+    REQUIRE(std::ranges::equal(assignment, std::initializer_list{1, 0, 2}));
+}
+
+TEST_CASE("Hungarian optimality", "[Algorithms]") {
+    std::mt19937 rand{42};
+    size_t num_error = 0;
+
+    for (int trial = 0; trial < 200; ++trial) {
+        size_t const n = 1 + trial % 7;
+        kangsw::ndarray<double, 2> costs(n, n);
+        for (auto& c : costs) { c = std::uniform_real_distribution{-5., 20.}(rand); }
+
+        // brute force over every permutation
+        std::vector<size_t> perm(n);
+        std::iota(perm.begin(), perm.end(), 0);
+        double best = std::numeric_limits<double>::max();
+        do {
+            double sum = 0;
+            for (size_t i = 0; i < n; ++i) { sum += costs(i, perm[i]); }
+            best = std::min(best, sum);
+        } while (std::next_permutation(perm.begin(), perm.end()));
+
+        auto copy = costs;
+        auto assignment = kangsw::algorithm::hungarian(std::move(copy));
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) { sum += costs(i, assignment[i]); }
+
+        std::sort(assignment.begin(), assignment.end());
+        num_error += std::adjacent_find(assignment.begin(), assignment.end()) != assignment.end();
+        num_error += std::abs(sum - best) > 1e-9;
+    }
+
+    CHECK(num_error == 0);
+
+    // large problem finishes in polynomial time; rows of identical costs are worst for greedy covering.
+    kangsw::ndarray<int, 2> large(600, 600);
+    for (auto const& idx : kangsw::counter(large.dims())) { large[idx] = int((idx[0] * 7 + idx[1] * 13) % 101); }
+    auto assignment = kangsw::algorithm::hungarian(std::move(large));
+    std::sort(assignment.begin(), assignment.end());
+    CHECK(std::adjacent_find(assignment.begin(), assignment.end()) == assignment.end());
+}
+
+TEST_CASE("Hungarian rectangular and gating", "[Algorithms]") {
+    using namespace kangsw::algorithm;
+    constexpr auto none = hungarian_unassigned;
+    constexpr auto X = hungarian_forbidden<float>;
+
+    kangsw::ndarray<float, 2> wide(2, 4);
+    wide.assign({9, 2, 7, 8,
+                 6, 4, 3, 7});
+    CHECK(hungarian(wide, {}) == hungarian_result_t{1, 2});
+
+    // more rows than columns; solved as transposed
+    kangsw::ndarray<float, 2> tall(4, 2);
+    tall.assign({9, 6,
+                 2, 4,
+                 7, 3,
+                 8, 7});
+    CHECK(hungarian(tall, {}) == hungarian_result_t{none, 0, 1, none});
+
+    // forbidden pairs may leave a row unassigned
+    kangsw::ndarray<float, 2> forbidden(3, 3);
+    forbidden.assign({1, X, X,
+                      2, X, X,
+                      X, 5, 1});
+    CHECK(hungarian(forbidden, {}) == hungarian_result_t{0, none, 2});
+
+    // as many rows as possible are assigned, then the cheapest of such pairs are taken
+    constexpr auto Xi = hungarian_forbidden<int>;
+    kangsw::ndarray<int, 2> contested(2, 2);
+    contested.assign({8, Xi,
+                      5, Xi});
+    CHECK(hungarian(contested, {}) == hungarian_result_t{none, 0});
+    kangsw::ndarray<float, 2> contested_tall(3, 2);
+    contested_tall.assign({9, X,
+                           2, X,
+                           X, X});
+    CHECK(hungarian(contested_tall, {}) == hungarian_result_t{none, 0, none});
+
+    // full assignment costs 5; with tight gate, pairing row 0 alone and leaving row 1 costs less
+    kangsw::ndarray<float, 2> gated(2, 2);
+    gated.assign({1, 3,
+                  2, 20});
+    CHECK(hungarian(gated, {}) == hungarian_result_t{1, 0});
+    CHECK(hungarian(gated, {.max_cost = 4.5f}) == hungarian_result_t{1, 0});
+    CHECK(hungarian(gated, {.max_cost = 2.5f}) == hungarian_result_t{0, none});
+
+    kangsw::sparse_builder<int> builder(3, 5);
+    builder.push(0, 4, 1), builder.push(1, 4, 2), builder.push(2, 0, 3), builder.push(1, 1, 9);
+    CHECK(hungarian(builder.build()) == hungarian_result_t{4, 1, 0});
+    CHECK(hungarian(builder.build<kangsw::sparse_format::csc>(), {.max_cost = 5}) == hungarian_result_t{4, none, 0});
+    CHECK(hungarian(builder.build().transpose().to_csr()) == hungarian_result_t{2, 1, none, none, 0});
+}
+
+TEMPLATE_TEST_CASE("Hungarian brute force", "[Algorithms]", int, float, double) {
+    using namespace kangsw::algorithm;
+    constexpr auto none = hungarian_unassigned;
+    constexpr auto X = hungarian_forbidden<TestType>;
+
+    // compare to brute force over partial assignments; without gate, fewest unassigned rows first
+    std::mt19937 rand{7};
+    size_t num_error = 0;
+    for (int trial = 0; trial < 600; ++trial) {
+        size_t const n = 1 + trial % 4, m = 1 + trial / 4 % 5;
+        bool const gated = trial % 2;
+        TestType const limit = 8;
+        kangsw::ndarray<TestType, 2> costs(n, m);
+        for (auto& c : costs) { c = rand() % 3 == 0 ? X : TestType(rand() % 12); }
+
+        auto objective = [&](hungarian_result_t const& r) {
+            double sum = 0;
+            for (size_t i = 0; i < n; ++i) { sum += r[i] != none ? costs(i, r[i]) : gated ? limit : 1000; }
+            return sum;
+        };
+
+        double best = std::numeric_limits<double>::max();
+        hungarian_result_t pick(n);
+        auto search = [&](auto&& self, size_t i, std::vector<bool>& taken) -> void {
+            if (i == n) { return void(best = std::min(best, objective(pick))); }
+            pick[i] = none, self(self, i + 1, taken);
+            for (size_t j = 0; j < m; ++j) {
+                if (taken[j] || costs(i, j) == X) { continue; }
+                taken[j] = true, pick[i] = j, self(self, i + 1, taken), taken[j] = false;
+            }
+        };
+        std::vector<bool> taken(m);
+        search(search, 0, taken);
+
+        hungarian_options<TestType> options;
+        if (gated) { options.max_cost = limit; }
+        auto result = hungarian(costs, options);
+        num_error += objective(result) != best;
+
+        std::vector<size_t> cols;
+        for (size_t i = 0; i < n; ++i) {
+            if (result[i] == none) { continue; }
+            num_error += result[i] >= m || costs(i, result[i]) == X;
+            cols.push_back(result[i]);
+        }
+        std::sort(cols.begin(), cols.end());
+        num_error += std::adjacent_find(cols.begin(), cols.end()) != cols.end();
+    }
+    CHECK(num_error == 0);
+}
+
+TEST_CASE("Hungarian solver reuse", "[Algorithms]") {
+    using namespace kangsw::algorithm;
+    hungarian_solver<float> solver;
+    solver.reserve(40, 40);
+
+    std::mt19937 rand{3};
+    kangsw::ndarray<float, 2> storage(40, 40);
+    for (auto& c : storage) { c = float(rand() % 100); }
+
+    size_t num_error = 0;
+    auto const buffer = solver.result().data();
+    for (size_t frame = 0; frame < 50; ++frame) {
+        size_t const n = 1 + rand() % 40, m = 1 + rand() % 40;
+        auto costs = storage.view().subview({0, 0}, {n, m});
+
+        // reused solver gives the same answer as fresh one, without reallocation
+        auto const& result = solver(costs, {.max_cost = 50.f});
+        num_error += result != hungarian_solver<float>{}(costs, {.max_cost = 50.f});
+        num_error += result.data() != buffer;
+    }
+    CHECK(num_error == 0);
+
+    // const array of caller
+    kangsw::ndarray<float, 2> const fixed{storage.view().subview({0, 0}, {3, 3})};
+    CHECK(solver(fixed).size() == 3);
+}
+
+TEMPLATE_TEST_CASE("Hungarian warm start", "[Algorithms]", float, int) {
+    using namespace kangsw::algorithm;
+    constexpr auto none = hungarian_unassigned;
+    constexpr auto X = hungarian_forbidden<TestType>;
+
+    std::mt19937 rand{11};
+    int forbid_every = 0;
+    auto random_cost = [&] { return forbid_every && rand() % forbid_every == 0 ? X : TestType(rand() % 1000); };
+
+    size_t num_error = 0;
+    for (auto [n, m, gate, forbid] : {std::tuple{30, 40, 0, 0}, {40, 30, 0, 0}, {30, 30, 0, 0}, {30, 30, 350, 0}, {25, 35, 200, 0},
+                                      {30, 30, 0, 6}, {20, 30, 0, 3}, {30, 20, 0, 3}, {30, 30, 350, 6}}) {
+        hungarian_options<TestType> options;
+        if (gate > 0) { options.max_cost = TestType(gate); }
+        forbid_every = forbid;
+
+        kangsw::ndarray<TestType, 2> storage(60, 60);
+        for (auto& c : storage) { c = random_cost(); }
+
+        // without gate, fewer unassigned rows always win
+        auto objective = [&](auto const& costs, hungarian_result_t const& r) {
+            double sum = 0;
+            for (size_t i = 0; i < r.size(); ++i) { sum += r[i] != none ? double(costs(i, r[i])) : gate ? gate : 1e7; }
+            return sum;
+        };
+
+        hungarian_solver<TestType> solver;
+        solver(storage.view().subview({0, 0}, {size_t(n), size_t(m)}), options);
+
+        for (int frame = 0; frame < 30; ++frame) {
+            // a few rows and columns change, and a track may appear or disappear at the end
+            for (int k = 0; k < 3; ++k) {
+                auto const r = rand() % n;
+                for (int c = 0; c < 60; ++c) { storage(r, c) = random_cost(); }
+            }
+            auto const changed = rand() % m;
+            for (int r = 0; r < 60; ++r) { storage(r, changed) = random_cost(); }
+            if (frame % 5 == 0) { n += rand() % 3 - 1, m += rand() % 3 - 1; }
+
+            auto costs = storage.view().subview({0, 0}, {size_t(n), size_t(m)});
+            auto const& warm = solver.resolve(costs, options);
+            auto const cold = hungarian_solver<TestType>{}(costs, options);
+
+            num_error += warm.size() != size_t(n);
+            num_error += std::abs(objective(costs, warm) - objective(costs, cold)) > 1e-3;
+
+            std::vector<size_t> cols;
+            for (size_t i = 0; i < warm.size(); ++i) {
+                if (warm[i] == none) { continue; }
+                num_error += costs(i, warm[i]) == X;
+                cols.push_back(warm[i]);
+            }
+            std::sort(cols.begin(), cols.end());
+            num_error += std::adjacent_find(cols.begin(), cols.end()) != cols.end();
+            num_error += solver.duals().rows.size() != size_t(n) || solver.duals().cols.size() != size_t(m);
+        }
+    }
+    CHECK(num_error == 0);
+}
+
+TEST_CASE("Hungarian duals", "[Algorithms]") {
+    using namespace kangsw::algorithm;
+    constexpr auto none = hungarian_unassigned;
+
+    // duals prove the optimality; reduced costs are non-negative, and zero on every pair
+    kangsw::ndarray<int, 2> costs(3, 4);
+    costs.assign({7, 2, 9, 4,
+                  3, 8, 1, 6,
+                  5, 5, 5, 2});
+    hungarian_solver<int> solver;
+    auto const result = solver(costs);
+    auto const duals = solver.duals();
+    for (auto [r, c] : kangsw::counter(3, 4)) {
+        auto const reduced = costs(r, c) - duals.rows[r] - duals.cols[c];
+        CHECK(reduced >= 0);
+        if (result[r] == size_t(c)) { CHECK(reduced == 0); }
+    }
+
+    // unchanged costs keep the same pairs, also from explicitly given state
+    CHECK(solver.resolve(costs.view(), result, duals) == result);
+    costs(0, 1) = 100, costs(2, 0) = 1;
+    CHECK(solver.resolve(costs.view()) == hungarian_result_t{3, 2, 0});
+
+    // a column freed by a forbidden pair is taken by the row which prefers it
+    constexpr auto X = hungarian_forbidden<float>;
+    kangsw::ndarray<float, 2> freed(2, 2);
+    freed.assign({8, 3,
+                  X, 4});
+    hungarian_solver<float> freed_solver;
+    CHECK(freed_solver(freed) == hungarian_result_t{0, 1});
+    freed.assign({8, 3,
+                  X, X});
+    CHECK(freed_solver.resolve(freed.view()) == hungarian_result_t{1, none});
+}
+
+TEST_CASE("Hungarian parallel", "[Algorithms]") {
+    using namespace kangsw::algorithm;
+    std::mt19937 rand{5};
+
+    kangsw::ndarray<float, 2> costs(300, 300);
+    for (auto& c : costs) { c = float(rand() % 10000) * 0.01f; }
+
+    auto const sequential = hungarian(costs, {});
+    CHECK(hungarian(std::execution::par, costs) == sequential);
+
+    // transposed view has strided rows, which are scanned without simd
+    auto const transposed = hungarian_solver<float>{}(costs.view().transpose());
+    double sum = 0, sum_transposed = 0;
+    for (size_t i = 0; i < 300; ++i) { sum += costs(i, sequential[i]), sum_transposed += costs(transposed[i], i); }
+    CHECK(std::abs(sum - sum_transposed) < 1e-2);
 }
@@ -1,9 +1,16 @@
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <execution>
+#include <memory_resource>
 #include <ranges>
 
 #include "catch.hpp"
 #include "kangsw/container/circular_queue.hxx"
+#include "kangsw/container/mapped_ndarray.hxx"
 #include "kangsw/container/ndarray.hxx"
+#include "kangsw/container/ndarray_expr.hxx"
+#include "kangsw/container/ndarray_ops.hxx"
+#include "kangsw/container/rolling_window.hxx"
+#include "kangsw/container/sparse_matrix.hxx"
 #include "kangsw/helpers/counter.hxx"
 
 namespace kangsw::container_test {
@@ -17,7 +24,7 @@ TEST_CASE("ndarray") {
     REQUIRE_THROWS(ndr.at(24, 34, 3));
 
     auto dim = ndr.dims();
-    for (auto& idx : counter(dim[0], dim[1], dim[2])) {
+    for (auto const& idx : counter(dim[0], dim[1], dim[2])) {
         ndr[idx] += 1;
     }
 
@@ -45,13 +52,328 @@ TEST_CASE("ndarray") {
 
     auto ff = ndr;
     for (auto& elem : ff) { elem = 0x9496; }
-    for (auto& idx : counter(dim)) { ndr[idx] = 0x9496; }
+    for (auto const& idx : counter(dim)) { ndr[idx] = 0x9496; }
 
     for (auto [target, gt] : zip(ndr, ff)) {
         CHECK(target == gt);
     }
 }
 
+TEST_CASE("ndarray_view") {
+    ndarray<int, 3> arr(4, 5, 3);
+    std::iota(arr.begin(), arr.end(), 0);
+    auto v = arr.view();
+    CHECK(v.is_contiguous());
+    CHECK(v.size() == arr.size());
+
+    size_t num_error = 0;
+    for (auto const& idx : counter(arr.dims())) { num_error += &v[idx] != &arr[idx]; }
+    CHECK(num_error == 0);
+
+    auto channel = v.slice(2, 1); // 4x5, shares storage
+    CHECK(channel.dims() == std::array<size_t, 2>{4, 5});
+    CHECK(channel(2, 3) == arr(2, 3, 1));
+    CHECK_FALSE(channel.is_contiguous());
+    channel(0, 0) = -1;
+    CHECK(arr(0, 0, 1) == -1);
+
+    auto t = channel.transpose();
+    CHECK(t.dims() == std::array<size_t, 2>{5, 4});
+    CHECK(&t(3, 2) == &channel(2, 3));
+    CHECK(&v.transpose({2, 0, 1})(1, 3, 4) == &arr(3, 4, 1));
+    REQUIRE_THROWS(v.transpose({0, 0, 1}));
+
+    auto sub = channel.submatrix(1, 2, 3, 2);
+    CHECK(sub.dims() == std::array<size_t, 2>{3, 2});
+    CHECK(&sub(2, 1) == &arr(3, 3, 1));
+    REQUIRE_THROWS(sub.at(3, 0));
+    REQUIRE_THROWS(channel.submatrix(3, 0, 2, 1));
+
+    auto every_other = channel.slice(1, 1, 5, 2);
+    CHECK(every_other.dims() == std::array<size_t, 2>{4, 2});
+    CHECK(&every_other(3, 1) == &arr(3, 3, 1));
+
+    ndarray<int, 1> row(3);
+    row.assign({10, 20, 30});
+    auto tiled = row.view().broadcast(4, 3);
+    CHECK(tiled.strides() == std::array<size_t, 2>{0, 1});
+    CHECK(tiled(3, 2) == 30);
+    REQUIRE_THROWS(row.view().broadcast(4, 2));
+
+    ndarray<int, 2> copied{sub};
+    CHECK(copied.dims() == sub.dims());
+    CHECK(copied(2, 1) == sub(2, 1));
+
+    ndarray_view<int const, 2> const_view = sub;
+    int sum = 0;
+    const_view.for_each([&](int x) { sum += x; });
+    CHECK(sum == std::reduce(copied.begin(), copied.end()));
+}
+
+TEST_CASE("ndarray aligned layout") {
+    ndarray<float, 3, aligned_layout<32>> arr(2, 3, 5);
+    CHECK(arr.size() == 30);
+    CHECK(arr.pitch() == 8);
+    CHECK(arr.steps() == std::array<size_t, 2>{24, 8});
+    CHECK_FALSE(arr.is_packed());
+
+    size_t num_misaligned = 0;
+    for (auto const& idx : counter<size_t>(2, 3)) { num_misaligned += reinterpret_cast<uintptr_t>(&arr(idx[0], idx[1], 0)) % 32 != 0; }
+    CHECK(num_misaligned == 0);
+
+    std::vector<float> values(30);
+    std::iota(values.begin(), values.end(), 0.f);
+    arr.assign(values.begin(), values.end());
+    CHECK(arr(1, 2, 4) == 29.f);
+    CHECK(arr.view().strides() == std::array<size_t, 3>{24, 8, 1});
+
+    ndarray<float, 3> dense{arr.view()};
+    CHECK(dense.is_packed());
+    CHECK(std::ranges::equal(dense.vector(), values));
+
+    ndarray<double, 2, aligned_layout<64>> packed(3, 8);
+    CHECK(packed.is_packed());
+    CHECK(reinterpret_cast<uintptr_t>(packed.data()) % 64 == 0);
+}
+
+TEST_CASE("ndarray fixed shape") {
+    using mat3 = fixed_ndarray<float, 3, 3>;
+    static_assert(std::is_same_v<mat3, ndarray<float, 2, fixed_shape<3, 3>>>);
+    static_assert(sizeof(mat3) == sizeof(float) * 9);
+    static_assert(mat3::dims() == std::array<size_t, 2>{3, 3});
+    static_assert(std::is_trivially_copyable_v<mat3>);
+
+    constexpr fixed_ndarray<int, 2, 3, 4> cube = [] {
+        fixed_ndarray<int, 2, 3, 4> r;
+        for (int i = 0; auto& e : r) { e = i++; }
+        return r;
+    }();
+    static_assert(cube(1, 2, 3) == 23 && cube[{1, 0, 2}] == 14);
+    CHECK(cube.steps() == std::array<size_t, 2>{12, 4});
+    CHECK(cube.view().slice(0, 1)(2, 3) == 23);
+
+    mat3 m = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+    CHECK(m(1, 2) == 6.f);
+    REQUIRE_THROWS(m.at(3, 0));
+    REQUIRE_THROWS(m.assign({1, 2}));
+
+    // interoperates with views, ops and expressions as dynamic arrays do
+    mat3 t{m.view().transpose()};
+    CHECK(t(2, 1) == 6.f);
+
+    mat3 s = m + t * 2.f;
+    CHECK(s(1, 2) == 6.f + 8.f * 2.f);
+    CHECK(ops::sum(m) == 45.f);
+
+    ndarray<float, 2> dyn{m.view()};
+    CHECK(std::ranges::equal(dyn.vector(), std::vector<float>(m.begin(), m.end())));
+    REQUIRE_THROWS((fixed_ndarray<float, 2, 2>{dyn.view()}));
+}
+
+TEST_CASE("ndarray ops") {
+    ndarray<float, 2> a(7, 19), b(7, 19), dst(7, 19);
+    for (auto const& idx : counter(a.dims())) {
+        a[idx] = float(idx[0] * 19 + idx[1]);
+        b[idx] = float((idx[0] * 7 + idx[1] * 3) % 11) - 5.f;
+    }
+
+    size_t num_error = 0;
+    ops::add(dst, a, b);
+    for (auto const& idx : counter(a.dims())) { num_error += dst[idx] != a[idx] + b[idx]; }
+    ops::fma(std::execution::par, dst, a, 2.f, b);
+    for (auto const& idx : counter(a.dims())) { num_error += dst[idx] != a[idx] * 2.f + b[idx]; }
+    ops::minimum(dst, a, b);
+    for (auto const& idx : counter(a.dims())) { num_error += dst[idx] != std::min(a[idx], b[idx]); }
+
+    // strided operand and broadcast one
+    ndarray<float, 2> t(19, 7), row(1, 7);
+    row.assign({1, 2, 3, 4, 5, 6, 7});
+    ops::sub(t.view().transpose(), a, row.view().broadcast(19, 7).transpose());
+    for (auto const& idx : counter(a.dims())) { num_error += t(idx[1], idx[0]) != a[idx] - float(idx[0] + 1); }
+
+    ndarray<int8_t, 2> mask(7, 19);
+    ops::compare(mask, b, 0, std::less<>{});
+    for (auto const& idx : counter(a.dims())) { num_error += mask[idx] != (b[idx] < 0); }
+    CHECK(num_error == 0);
+    REQUIRE_THROWS(ops::add(dst, a, t));
+
+    CHECK(ops::sum(a) == 132.f * 133.f / 2.f);
+    CHECK(ops::min(std::execution::par, b) == -5.f);
+    auto at = ops::argmin(b);
+    CHECK(b[at] == -5.f);
+    CHECK(at == std::array<size_t, 2>{0, 0});
+
+    ndarray<float, 1> row_min(7), col_min(19), row_sum(7);
+    ndarray<size_t, 1> row_arg(7), col_arg(19);
+    ops::min_axis(row_min, b, 1);
+    ops::min_axis(col_min, b, 0);
+    ops::sum_axis(std::execution::par, row_sum, a, 1);
+    ops::argmin_axis(row_arg, b, 1);
+    ops::argmin_axis(col_arg, b, 0);
+
+    for (size_t r = 0; r < 7; ++r) {
+        auto rv = b.view().slice(0, r);
+        auto it = std::min_element(&rv(0), &rv(0) + 19);
+        num_error += row_min(r) != *it || row_arg(r) != size_t(it - &rv(0));
+        num_error += row_sum(r) != float(19 * 19 * r + 171);
+    }
+    for (size_t c = 0; c < 19; ++c) {
+        size_t best = 0;
+        for (size_t r = 1; r < 7; ++r) { best = b(r, c) < b(best, c) ? r : best; }
+        num_error += col_min(c) != b(best, c) || col_arg(c) != best;
+    }
+    CHECK(num_error == 0);
+
+    ops::fill(std::execution::par, a.view().submatrix(1, 1, 3, 3), -1.f);
+    CHECK(ops::sum(a.view().submatrix(1, 1, 3, 3)) == -9.f);
+    CHECK(a(0, 0) == 0.f);
+    CHECK(a(4, 4) == 80.f);
+}
+
+TEST_CASE("ndarray expressions") {
+    ndarray<float, 2> b(5, 13), c(5, 13), d(5, 13);
+    for (auto const& idx : counter(b.dims())) {
+        b[idx] = float(idx[0] + idx[1]);
+        c[idx] = float(idx[1] % 3) - 1.f;
+        d[idx] = float(idx[0]) * 0.5f;
+    }
+
+    ndarray<float, 2> a = b * c + d;
+    CHECK(a.dims() == b.dims());
+
+    size_t num_error = 0;
+    for (auto const& idx : counter(b.dims())) { num_error += a[idx] != b[idx] * c[idx] + d[idx]; }
+
+    // scalars, views and nested expressions
+    a = -(b - 1.f) / 2 + c.view().transpose().transpose() * d;
+    for (auto const& idx : counter(b.dims())) { num_error += a[idx] != -(b[idx] - 1.f) / 2 + c[idx] * d[idx]; }
+
+    ndarray<float, 2> t(13, 5);
+    ops::evaluate(std::execution::par, t.view().transpose(), b * 2.f);
+    for (auto const& idx : counter(b.dims())) { num_error += t(idx[1], idx[0]) != b[idx] * 2.f; }
+    CHECK(num_error == 0);
+
+    auto expected = 0.f;
+    for (auto const& idx : counter(b.dims())) { expected += b[idx] * c[idx] - d[idx]; }
+    CHECK(ops::sum(b * c - d) == Approx(expected));
+    CHECK(ops::min(std::execution::par, b * c) == -16.f);
+
+    ndarray<int, 1> i(3), j(3);
+    i.assign({1, 2, 3}), j.assign({4, 5, 6});
+    ndarray<int, 1> k = i * j - 1;
+    CHECK(k.vector() == std::vector{3, 9, 17});
+
+    REQUIRE_THROWS(b + t);
+}
+
+TEST_CASE("mapped_ndarray") {
+    auto const path = std::filesystem::temp_directory_path() / "kangsw-mapped-ndarray.npy";
+
+    ndarray<float, 2> src(7, 9);
+    for (auto const& idx : counter(src.dims())) { src[idx] = float(idx[0] * 100 + idx[1]); }
+    save_npy(path, src);
+
+    size_t num_error = 0;
+    {
+        mapped_ndarray<float, 2> m(path);
+        REQUIRE(m.dims() == src.dims());
+        for (auto const& idx : counter(src.dims())) { num_error += m[idx] != src[idx]; }
+        REQUIRE_THROWS(m.mutable_view());
+
+        // header is padded, thus data is aligned for any element type
+        CHECK(reinterpret_cast<uintptr_t>(m.view().data()) % 64 == 0);
+    }
+
+    {
+        mapped_ndarray<float, 2> m(path, map_mode::copy_on_write);
+        m.mutable_view()(3, 4) = -1.f;
+        CHECK(m(3, 4) == -1.f);
+    }
+    CHECK(mapped_ndarray<float, 2>(path)(3, 4) == 304.f);
+
+    // strided views are written in their own row-major order
+    save_npy(path, src.view().transpose());
+    {
+        mapped_ndarray<float, 2> m(path);
+        REQUIRE(m.dims() == std::array<size_t, 2>{9, 7});
+        for (auto const& idx : counter(src.dims())) { num_error += m(idx[1], idx[0]) != src[idx]; }
+    }
+
+    // fortran ordered file maps as transposed strides
+    {
+        std::array<size_t, 2> shape = {9, 7};
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file << _npy::make_header(_npy::descr<float>(), true, shape.data(), 2);
+        file.write(reinterpret_cast<char const*>(src.data()), src.size() * sizeof(float));
+    }
+    {
+        mapped_ndarray<float, 2> m(path);
+        REQUIRE(m.dims() == std::array<size_t, 2>{9, 7});
+        for (auto const& idx : counter(src.dims())) { num_error += m(idx[1], idx[0]) != src[idx]; }
+    }
+    CHECK(num_error == 0);
+
+    REQUIRE_THROWS_AS((mapped_ndarray<double, 2>(path)), std::invalid_argument);
+    REQUIRE_THROWS_AS((mapped_ndarray<float, 3>(path)), std::invalid_argument);
+    REQUIRE_THROWS_AS((mapped_ndarray<float, 2>(path.string() + ".missing")), std::system_error);
+
+    // extents of which product wraps around must not pass the size check
+    {
+        std::array<size_t, 2> shape = {size_t(1) << 62, 8};
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file << _npy::make_header(_npy::descr<float>(), false, shape.data(), 2);
+        file.write(reinterpret_cast<char const*>(src.data()), src.size() * sizeof(float));
+    }
+    REQUIRE_THROWS_AS((mapped_ndarray<float, 2>(path)), std::invalid_argument);
+
+    std::ofstream{path, std::ios::binary | std::ios::trunc}.close();
+    REQUIRE_THROWS_AS((mapped_ndarray<float, 2>(path)), std::invalid_argument);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("sparse_matrix") {
+    sparse_builder<float> builder(4, 6);
+    builder.push(2, 5, 1.f);
+    builder.push(0, 3, 2.f);
+    builder.push(2, 1, 3.f);
+    builder.push(3, 0, 4.f);
+    builder.push(2, 5, 10.f); // duplicated
+    REQUIRE_THROWS(builder.push(4, 0, 0.f));
+
+    auto csr = builder.build();
+    CHECK(csr.dims() == std::array<size_t, 2>{4, 6});
+    CHECK(csr.nnz() == 4);
+    CHECK(csr.value_or(2, 5, 0.f) == 11.f);
+    CHECK(csr.find(1, 1) == nullptr);
+    CHECK(std::ranges::equal(csr.indices(2), std::vector<uint32_t>{1, 5}));
+    CHECK(csr.values(1).empty());
+
+    std::vector<std::pair<uint32_t, float>> row;
+    for (auto [col, value] : csr.row(2)) { row.emplace_back(col, value); }
+    CHECK(row == std::vector<std::pair<uint32_t, float>>{{1, 3.f}, {5, 11.f}});
+
+    // conversions keep entries, in either direction
+    auto csc = csr.to_csc();
+    CHECK(csc == builder.build<sparse_format::csc>());
+    CHECK(std::ranges::equal(csc.indices(5), std::vector<uint32_t>{2}));
+    CHECK(csc.to_csr() == csr);
+
+    auto dense = csr.to_dense(-1.f);
+    CHECK(dense(0, 3) == 2.f);
+    CHECK(dense(1, 1) == -1.f);
+    CHECK(sparse_matrix<float>{dense.view(), [](float v) { return v >= 0; }} == csr);
+    CHECK(sparse_matrix<float, sparse_format::csc>{dense.view(), [](float v) { return v >= 0; }} == csc);
+
+    auto t = csr.transpose();
+    static_assert(decltype(t)::format == sparse_format::csc);
+    CHECK(t.dims() == std::array<size_t, 2>{6, 4});
+    CHECK(t.value_or(5, 2, 0.f) == 11.f);
+    CHECK(std::ranges::equal(t.col(2), csr.row(2)));
+
+    *csr.find(0, 3) = 5.f;
+    CHECK(csr.value_or(0, 3, 0.f) == 5.f);
+}
+
 TEST_CASE("circular_queue") {
     circular_queue<int> s1{256};
     auto s2 = s1;
@@ -82,4 +404,208 @@ TEST_CASE("circular_queue") {
         CHECK(std::equal(cnt2.begin(), cnt2.end(), s.begin()));
     }
 }
+
+TEST_CASE("circular_queue power of two") {
+    circular_queue<int, true> s{200};
+    CHECK(s.capacity() == 256);
+    CHECK(circular_queue<int, true>{0}.is_full());
+
+    for (auto i : counter(1000)) { s.push_rotate(i); }
+    CHECK(s.is_full());
+    CHECK(s.size() == 256);
+    CHECK(s.front() == 1000 - 256);
+    CHECK(s.back() == 999);
+
+    auto cnt = iota(1000 - 256, 1000);
+    CHECK(std::equal(cnt.begin(), cnt.end(), s.begin()));
+    CHECK(s.end() - s.begin() == 256);
+    CHECK(*(s.begin() + 100) == 1000 - 256 + 100);
+    CHECK(*(s.end() - 1) == 999);
+    CHECK(s.begin()[255] == 999);
+
+    std::sort(s.begin(), s.end(), [](auto a, auto b) { return b < a; });
+    CHECK(s.front() == 999);
+    CHECK(s.back() == 1000 - 256);
+
+    s.reserve_shrink(100);
+    CHECK(s.capacity() == 128);
+    CHECK(s.size() == 128);
+    CHECK(s.front() == 999);
+}
+
+TEST_CASE("circular_queue spans and bulk operations") {
+    circular_queue<double> s{10};
+    auto [e0, e1] = s.as_spans();
+    CHECK(e0.empty());
+    CHECK(e1.empty());
+
+    std::vector<double> values(8);
+    std::iota(values.begin(), values.end(), 0.);
+    s.push_range(values);
+    s.pop_n(6);
+    s.push_range(values); // wraps around
+
+    auto [a, b] = s.as_spans();
+    CHECK(a.size() + b.size() == 10);
+    CHECK(b.size() > 0);
+    CHECK(a.front() == 6.);
+    CHECK(b.back() == 7.);
+    CHECK(std::reduce(a.begin(), a.end()) + std::reduce(b.begin(), b.end()) == 6 + 7 + 28);
+    REQUIRE_THROWS(s.push_range(values));
+
+    std::vector<double> copied(10);
+    s.copy_out(copied.data());
+    CHECK(std::equal(copied.begin(), copied.end(), s.begin()));
+
+    double popped[3];
+    CHECK(s.pop_n(popped, 3) == 3);
+    CHECK(popped[2] == 0.);
+    CHECK(s.size() == 7);
+
+    circular_queue<std::string, true> strs{4};
+    std::string in[] = {"a", "b", "c"};
+    strs.push_range(std::begin(in), std::end(in));
+    strs.pop_n(2);
+    strs.push_range(std::begin(in), std::end(in));
+
+    std::vector<std::string> out;
+    strs.copy_out(std::back_inserter(out));
+    CHECK(out == std::vector<std::string>{"c", "a", "b", "c"});
+    CHECK(strs.pop_n(out.begin(), 2) == 2);
+    CHECK(out[1] == "a");
+    CHECK(strs.front() == "b");
+}
+
+TEST_CASE("circular_queue allocator and growth") {
+    struct alignas(64) wide {
+        int value;
+    };
+
+    circular_queue<wide> w{3};
+    w.push({1});
+    CHECK(reinterpret_cast<uintptr_t>(&w.front()) % 64 == 0);
+
+    circular_queue<int> s{5};
+    for (int i : {0, 1, 2, 3, 4}) { s.push(i); }
+    s.pop_n(3);
+    for (int i : {5, 6, 7}) { s.push(i); } // wraps around
+    s.reserve(12);
+    CHECK(s.capacity() == 12);
+    CHECK(s.as_spans().second.empty());
+    CHECK(std::ranges::equal(s, std::vector{3, 4, 5, 6, 7}));
+
+    s.reserve_shrink(2);
+    CHECK(std::ranges::equal(s, std::vector{3, 4}));
+
+    circular_queue<int> empty{0};
+    empty = s;
+    CHECK(std::ranges::equal(empty, s));
+
+    std::byte buffer[1024];
+    std::pmr::monotonic_buffer_resource arena{buffer, sizeof buffer, std::pmr::null_memory_resource()};
+    pmr::circular_queue<std::string, true> strs{4, &arena};
+    for (auto str : {"a", "b", "c", "d", "e"}) {
+        if (strs.is_full()) { strs.reserve(strs.capacity() * 2); }
+        strs.push(str);
+    }
+    CHECK(strs.capacity() == 8);
+    CHECK(strs.back() == "e");
+    CHECK(strs.get_allocator().resource() == &arena);
+
+    auto copied = strs;
+    CHECK(std::ranges::equal(copied, strs));
+}
+
+TEST_CASE("circular_queue allocator-aware elements") {
+    std::pmr::unsynchronized_pool_resource res_a, res_b;
+    std::pmr::string const long_str(64, 'x'); // defeats small string optimization
+
+    pmr::circular_queue<std::pmr::string> a{2, &res_a};
+    a.push(std::pmr::string{long_str});
+    a.push(std::pmr::string{long_str});
+    a.pop();
+    a.push(std::pmr::string{long_str}); // wraps around
+    a.reserve(4);
+    for (auto& str : a) { CHECK(str.get_allocator().resource() == &res_a); }
+
+    pmr::circular_queue<std::pmr::string> b{1, &res_b};
+    b = std::move(a); // unequal resources, elements are moved one by one
+    CHECK(b.get_allocator().resource() == &res_b);
+    CHECK(b.size() == 2);
+    CHECK(a.empty());
+    for (auto& str : b) {
+        CHECK(str == long_str);
+        CHECK(str.get_allocator().resource() == &res_b);
+    }
+
+    pmr::circular_queue<std::pmr::string> c{4, &res_a};
+    c.push_range(b);
+    for (auto& str : c) { CHECK(str.get_allocator().resource() == &res_a); }
+
+    // elements built before a throwing copy must be destroyed.
+    static int num_alive = 0;
+    struct fragile {
+        bool fail = false;
+        fragile(bool f = false) : fail(f) { ++num_alive; }
+        fragile(fragile const& o) : fail(o.fail) {
+            if (fail) { throw std::runtime_error("copy"); }
+            ++num_alive;
+        }
+        ~fragile() { --num_alive; }
+    };
+
+    {
+        circular_queue<fragile> q{4};
+        q.push(fragile{});
+        q.push(fragile{});
+        q.pop_n(2);
+        q.push(fragile{}); // head is at the last slot
+
+        std::vector<fragile> src(3);
+        src[2].fail = true;
+        CHECK_THROWS(q.push_range(src.begin(), src.end()));
+        CHECK(q.size() == 1);
+        CHECK(num_alive == 4);
+    }
+    CHECK(num_alive == 0);
+}
+
+TEST_CASE("rolling_window") {
+    rolling_window<double, rolling::sum, rolling::mean, rolling::variance, rolling::min, rolling::max> w{37};
+    std::vector<double> history;
+    size_t num_error = 0;
+
+    for (int i = 0; i < 1000; ++i) {
+        auto v = (rand() % 2000) / 10. - 100.;
+        w.push(v);
+        history.push_back(v);
+
+        auto begin = history.end() - std::min<ptrdiff_t>(history.size(), 37);
+        auto n = double(history.end() - begin);
+        auto sum = std::reduce(begin, history.end());
+        auto mean = sum / n;
+        auto var = std::transform_reduce(begin, history.end(), 0., std::plus<>{}, [&](double x) { return (x - mean) * (x - mean); }) / n;
+
+        num_error += std::abs(w.get<rolling::sum>() - sum) > 1e-9;
+        num_error += std::abs(w.get<rolling::mean>() - mean) > 1e-9;
+        num_error += std::abs(w.get<rolling::variance>() - var) > 1e-6;
+        num_error += w.get<rolling::min>() != *std::min_element(begin, history.end());
+        num_error += w.get<rolling::max>() != *std::max_element(begin, history.end());
+
+        if (i % 100 == 99) {
+            auto drift = w.get<rolling::variance>();
+            w.resync();
+            num_error += std::abs(w.get<rolling::variance>() - drift) > 1e-6;
+            num_error += w.get<rolling::max>() != *std::max_element(begin, history.end());
+        }
+    }
+
+    CHECK(num_error == 0);
+    CHECK(w.size() == 37);
+
+    rolling_window<int, rolling::mean, rolling::min> iw{4};
+    for (int v : {5, 3, 8, 1, 9, 9}) { iw.push(v); }
+    CHECK(iw.get<rolling::min>() == 1);
+    CHECK(iw.get<rolling::mean>() == 27 / 4.);
+}
 } // namespace kangsw::container_test
@@ -7,6 +7,7 @@
  * ----------------------------------------------------------------------------
  */
 #include <algorithm>
+#include <atomic>
 
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
@@ -196,11 +197,88 @@ TEST_CASE("ownership") {
     REQUIRE(owner::callcnt_ == 1);
 }
 
+TEST_CASE("tiled index space") {
+    auto t = tiles(std::array<size_t, 3>{5, 9, 7}, {2, 4, 7});
+    REQUIRE(t.size() == 3 * 3 * 1);
+    CHECK(t.end() - t.begin() == 9);
+
+    auto last = t[8];
+    CHECK(last.offset == std::array<size_t, 3>{4, 8, 0});
+    CHECK(last.extent == std::array<size_t, 3>{1, 1, 7});
+    CHECK((t.begin() + 4)[0].offset == std::array<size_t, 3>{2, 4, 0});
+
+    std::vector<int> visited(5 * 9 * 7);
+    for_each_partition(
+      std::execution::par, t.begin(), t.end(), [&](auto const& tile) {
+          tile.for_each([&](auto& idx) { visited[(idx[0] * 9 + idx[1]) * 7 + idx[2]]++; });
+      },
+      4);
+    CHECK(std::all_of(visited.begin(), visited.end(), [](int v) { return v == 1; }));
+
+    // shaped by element budget; whole rows first
+    auto s = tiles(std::array<size_t, 2>{100, 300}, 1024);
+    CHECK(s[0].extent == std::array<size_t, 2>{3, 300});
+    CHECK(s.size() == 34);
+    CHECK(s[33].extent == std::array<size_t, 2>{1, 300});
+
+    REQUIRE_THROWS(tiles(std::array<size_t, 2>{4, 4}, {0, 1}));
+}
+
+TEST_CASE("n-dim counter random access") {
+    auto range = counter(std::array<int, 3>{7, 5, 3});
+    static_assert(std::is_same_v<std::iterator_traits<decltype(range.begin())>::iterator_category, std::random_access_iterator_tag>);
+    static_assert(std::random_access_iterator<decltype(counter(std::array<int, 3>{7, 5, 3}).begin())>);
+    REQUIRE(range.end() - range.begin() == 105);
+
+    std::vector<std::array<int, 3>> sequential;
+    for (auto const& idx : range) { sequential.push_back(idx); }
+    REQUIRE(sequential.size() == 105);
+
+    size_t num_error = 0;
+    for (int n = 0; n < 105; ++n) {
+        auto it = range.begin() + n;
+        num_error += *it != sequential[n];
+        num_error += it.index() != n;
+        num_error += (range.end() - (105 - n)) != it;
+    }
+    CHECK(num_error == 0);
+
+    auto it = range.begin() + 104;
+    CHECK(*--it == sequential[103]);
+    CHECK(range.begin()[52] == sequential[52]);
+    CHECK(*(range.begin() + 105) == std::array<int, 3>{7, 5, 3});
+
+    std::vector<std::atomic_int> visited(105);
+    std::for_each(std::execution::par, range.begin(), range.end(), [&](auto const& idx) { visited[(idx[0] * 5 + idx[1]) * 3 + idx[2]]++; });
+    CHECK(std::all_of(visited.begin(), visited.end(), [](auto& v) { return v == 1; }));
+
+    // coordinates are yielded by value, thus a shared iterator can be indexed concurrently
+    static_assert(std::is_same_v<decltype(range.begin()[0]), std::array<int, 3>>);
+    std::vector<std::array<int, 3>> peeked(105);
+    auto const shared = range.begin();
+    iota indices(105);
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](int n) { peeked[n] = shared[n]; });
+    CHECK(peeked == sequential);
+
+    auto empty = counter(std::array<size_t, 2>{4, 0});
+    CHECK(empty.begin() == empty.end());
+
+    // magic numbers divide exactly for any divisor and numerator
+    uint64_t x = 0x9e3779b97f4a7c15;
+    for (int i = 0; i < 10000; ++i) {
+        x ^= x << 13, x ^= x >> 7, x ^= x << 17;
+        auto const divisor = i < 5000 ? (x >> (i % 64)) | 1 : uint64_t(i);
+        num_error += _magic_divider(divisor).divide(x) != x / divisor;
+        num_error += _magic_divider(divisor).divide(divisor - 1) != 0;
+    }
+    CHECK(num_error == 0);
+}
+
 TEST_CASE("n-dim counter", "[.]") {
     constexpr size_t I = 150, J = 100, K = 100;
    static bool set[I][J][K] = {};
 
-    for (auto& index : counter(I, J, K)) {
+    for (auto const& index : counter(I, J, K)) {
         set[index[0]][index[1]][index[2]] = true;
     }
 
@@ -217,7 +295,7 @@ TEST_CASE("n-dim counter", "[.]") {
     int g = 0;
     BENCHMARK("3D Counter bench") {
         k = 0;
-        for (auto& c : counter(I, J, K)) {
+        for (auto const& c : counter(I, J, K)) {
             k = g++;
         }
     };
@@ -10,6 +10,8 @@
 #include <thread>
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
+#include "kangsw/container/broadcast_ring.hxx"
+#include "kangsw/container/spsc_circular_queue.hxx"
 #include "kangsw/thread/atomic_queue.hxx"
 #include "kangsw/helpers/misc.hxx"
 
@@ -118,4 +120,137 @@ TEST_CASE("Queue async operations", "[lock_free_queue]") {
     CHECK(zero_cnt == 0);
     CHECK((destinations.size() - not_one_count) == 0);
 } // namespace kangsw::container_test::queue
+
+TEST_CASE("SPSC queue operations", "[lock_free_queue]") {
+    spsc_circular_queue<std::string> queue{4};
+    REQUIRE(queue.empty());
+    REQUIRE(queue.capacity() == 4);
+
+    for (int i = 0; i < 4; ++i) { REQUIRE(queue.try_push(std::to_string(i))); }
+    REQUIRE_FALSE(queue.try_push("overflow"));
+    REQUIRE(queue.size() == 4);
+
+    std::string v;
+    REQUIRE(queue.try_pop(v));
+    CHECK(v == "0");
+
+    // wrap around with bulk operations
+    std::string in[] = {"a", "b", "c"};
+    CHECK(queue.push_n(in, 3) == 1);
+    std::string out[8];
+    REQUIRE(queue.pop_n(out, 8) == 4);
+    CHECK(out[0] == "1");
+    CHECK(out[3] == "a");
+    CHECK(queue.push_n(in, 3) == 3);
+    CHECK(queue.size() == 3);
+}
+
+TEST_CASE("SPSC queue async operations", "[lock_free_queue]") {
+    using namespace std::chrono_literals;
+    static constexpr size_t num_case = 1 << 22;
+    spsc_circular_queue<size_t> queue{1000};
+
+    std::thread producer([&]() {
+        size_t buf[64];
+        for (size_t i = 0; i < num_case;) {
+            if (i % 3) {
+                i += queue.try_push(i);
+                continue;
+            }
+
+            auto n = std::min<size_t>(std::size(buf), num_case - i);
+            std::iota(buf, buf + n, i);
+            for (size_t k = 0; k < n;) { k += queue.push_n(buf + k, n - k); }
+            i += n;
+        }
+    });
+
+    size_t num_error = 0;
+    size_t next = 0;
+    size_t buf[77];
+    while (next < num_case) {
+        if (next % 2) {
+            size_t v;
+            if (queue.try_pop(v)) { num_error += v != next++; }
+            continue;
+        }
+
+        auto n = queue.pop_n(buf, std::size(buf));
+        for (size_t k = 0; k < n; ++k) { num_error += buf[k] != next++; }
+    }
+
+    producer.join();
+    CHECK(num_error == 0);
+    CHECK(queue.empty());
+}
+
+TEST_CASE("Broadcast ring operations", "[lock_free_queue]") {
+    broadcast_ring<std::string> ring{3, 2};
+    REQUIRE(ring.capacity() == 4);
+
+    auto a = ring.subscribe();
+    {
+        auto b = ring.subscribe();
+        REQUIRE_THROWS(ring.subscribe());
+
+        for (int i = 0; i < 4; ++i) { REQUIRE(ring.try_push(std::to_string(i))); }
+        REQUIRE_FALSE(ring.try_push("overflow"));
+
+        // events are stored once, and shared by every consumer
+        CHECK(a.peek().first.data() == b.peek().first.data());
+        CHECK(b.consume([](auto&) {}) == 4);
+        REQUIRE_FALSE(ring.try_push("overflow")); // gated by the slowest consumer
+    }
+    CHECK(ring.num_consumers() == 1);
+
+    std::string v;
+    REQUIRE(a.try_pop(v));
+    CHECK(v == "0");
+    REQUIRE(ring.try_push("4"));
+
+    auto [s0, s1] = a.peek();
+    CHECK(s0.size() == 3);
+    CHECK(s1.size() == 1);
+    CHECK(s1.front() == "4");
+}
+
+TEMPLATE_TEST_CASE_SIG("Broadcast ring async operations", "[lock_free_queue]", ((bool MultiWriter_), MultiWriter_), false, true) {
+    static constexpr size_t num_case = 1 << 18;
+    static constexpr size_t num_consumer = 3;
+    static constexpr size_t num_producer = MultiWriter_ ? 4 : 1;
+    broadcast_ring<size_t, MultiWriter_> ring{1000, num_consumer};
+
+    std::vector<typename decltype(ring)::consumer> consumers;
+    for (size_t i = 0; i < num_consumer; ++i) { consumers.push_back(ring.subscribe()); }
+
+    std::vector<std::thread> threads;
+    std::vector<size_t> num_errors(num_consumer);
+    for (size_t i = 0; i < num_consumer; ++i) {
+        threads.emplace_back([&, i]() {
+            // per-producer order must be kept
+            std::vector<size_t> next(num_producer);
+            for (size_t n = 0; n < num_case;) {
+                n += consumers[i].consume([&](size_t v) {
+                    num_errors[i] += v % num_case != next[v / num_case]++;
+                });
+            }
+        });
+    }
+
+    for (size_t p = 0; p < num_producer; ++p) {
+        threads.emplace_back([&, p]() {
+            for (size_t i = 0; i < num_case / num_producer; ++i) {
+                auto v = p * num_case + i;
+                if (i % 2) { ring.push(v); }
+                else {
+                    while (!ring.try_push(v)) { std::this_thread::yield(); }
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) { t.join(); }
+    CHECK(num_errors == std::vector<size_t>(num_consumer));
+    for (auto& c : consumers) { CHECK(c.available() == 0); }
+}
 } // namespace kangsw::container_test::queue
\ No newline at end of file
@@ -9,7 +9,9 @@
 #include <array>
 #include <iomanip>
 #include <iostream>
+#include <memory_resource>
 #include <kangsw/helpers/misc.hxx>
+#include <kangsw/thread/strand.hxx>
 #include <kangsw/thread/thread_pool.hxx>
 #define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include "catch.hpp"
@@ -165,4 +167,285 @@ TEST_CASE("Timer accuracy test", "[.]") {
     WARN("Num Workers      : " << workers.num_workers());
     REQUIRE(to_micro(min_v) < 500);
 }
-} // namespace kangsw::thread_pool_test
\ No newline at end of file
+
+TEST_CASE("strand serial execution", "[thread_pool]") {
+    static constexpr int NUM_STRAND = 16;
+    static constexpr int NUM_CASE = 2048;
+    thread_pool workers{1024, 4};
+
+    vector<unique_ptr<strand>> strands;
+    vector<vector<int>> results(NUM_STRAND);
+    vector<atomic_int> num_running(NUM_STRAND);
+    atomic_int num_overlap = 0;
+
+    for (int i = 0; i < NUM_STRAND; ++i) { strands.emplace_back(make_unique<strand>(workers, 16)); }
+
+    vector<std::shared_ptr<future_proxy<int>>> lasts;
+    for (int i = 0; i < NUM_CASE; ++i) {
+        for (int s = 0; s < NUM_STRAND; ++s) {
+            auto future = strands[s]->add_task([&, s, i]() {
+                num_overlap += num_running[s]++ != 0;
+                results[s].push_back(i);
+                num_running[s]--;
+                return i;
+            });
+            if (i + 1 == NUM_CASE) { lasts.push_back(future); }
+        }
+    }
+
+    for (auto& last : lasts) { CHECK(last->get() == NUM_CASE - 1); }
+    CHECK(num_overlap == 0);
+
+    auto cnt = counter(NUM_CASE);
+    for (auto& result : results) {
+        REQUIRE(result.size() == NUM_CASE);
+        CHECK(std::equal(cnt.begin(), cnt.end(), result.begin()));
+    }
+}
+
+TEST_CASE("strand with full pool queue", "[thread_pool]") {
+    thread_pool workers{4, 1};
+    workers.launch_timeout_ms = 10ms;
+
+    atomic_bool started = false, release = false;
+    workers.add_task([&] {
+        started = true;
+        while (!release) { this_thread::sleep_for(1ms); }
+    });
+    while (!started) { this_thread::yield(); }
+
+    bool is_full = false;
+    for (int i = 0; i < 64 && !is_full; ++i) {
+        try {
+            workers.add_task([] {});
+        } catch (thread_pool_exception&) {
+            is_full = true;
+        }
+    }
+
+    // drain can't be queued, thus it runs on this thread rather than wedging the strand
+    strand serial{workers};
+    auto first = serial.add_task([] { return this_thread::get_id(); });
+    auto const ran_inline = first->view().wait_for(0s) == future_status::ready;
+    auto const num_pending = serial.num_pending_task();
+    release = true;
+
+    CHECK(is_full);
+    CHECK(ran_inline);
+    CHECK(num_pending == 0);
+    CHECK(first->get() == this_thread::get_id());
+
+    auto second = serial.add_task([] { return 2; });
+    CHECK(second->get() == 2);
+
+    // counter is decreased after the task returns
+    for (auto begin = chrono::system_clock::now(); serial.num_pending_task() != 0;) {
+        REQUIRE(chrono::system_clock::now() - begin < 5s);
+        this_thread::sleep_for(1ms);
+    }
+}
+
+TEST_CASE("task memory resource", "[thread_pool]") {
+    thread_pool workers{1024, 2};
+    CHECK(thread_pool::task_memory_resource() == std::pmr::get_default_resource());
+
+    vector<std::shared_ptr<future_proxy<size_t>>> futures;
+    for (int i = 0; i < 64; ++i) {
+        futures.push_back(workers.add_task([i]() -> size_t {
+            auto resource = thread_pool::task_memory_resource();
+            if (resource == std::pmr::get_default_resource()) { return 0; }
+
+            std::pmr::vector<int> scratch{resource};
+            for (int k = 0; k < 1000 + i; ++k) { scratch.push_back(k); }
+            std::pmr::string str{"task-local scratch string which does not fit in SSO", resource};
+            return scratch.size() + str.empty();
+        }));
+    }
+
+    for (int i = 0; i < 64; ++i) { CHECK(futures[i]->get() == 1000 + i); }
+}
+
+TEST_CASE("thread pool batched small tasks", "[thread_pool]") {
+    static constexpr int NUM_CASE = 200000;
+    thread_pool workers{1024, 4};
+    workers.max_batch_size = 64;
+
+    vector<atomic_int> executed(NUM_CASE);
+    atomic_int num_done = 0;
+
+    iota counter(NUM_CASE);
+    for_each(std::execution::par, counter.begin(), counter.end(), [&](int i) {
+        workers.add_task([&, i]() {
+            executed[i]++;
+            num_done++;
+        });
+    });
+
+    for (auto begin = chrono::system_clock::now(); num_done < NUM_CASE;) {
+        REQUIRE(chrono::system_clock::now() - begin < 30s);
+        this_thread::sleep_for(1ms);
+    }
+
+    CHECK(std::all_of(executed.begin(), executed.end(), [](auto& v) { return v == 1; }));
+    CHECK(workers.num_pending_task() == 0);
+}
+
+TEST_CASE("thread pool task waiting on its batch sibling", "[thread_pool]") {
+    thread_pool workers{1024, 2};
+
+    // shrink observed task durations, so that a worker fetches several tasks at once
+    atomic_int num_warmup = 0;
+    for (int i = 0; i < 4096; ++i) { workers.add_task([&] { num_warmup++; }); }
+    for (auto begin = chrono::system_clock::now(); num_warmup < 4096;) {
+        REQUIRE(chrono::system_clock::now() - begin < 30s);
+        this_thread::sleep_for(1ms);
+    }
+
+    for (int round = 0; round < 32; ++round) {
+        atomic_int num_started = 0;
+        atomic_bool release = false, sibling_done = false, sibling_seen = false;
+
+        // occupy every worker, so that the waiter and its sibling are fetched together
+        for (int i = 0; i < 2; ++i) {
+            workers.add_task([&] {
+                num_started++;
+                while (!release) { this_thread::yield(); }
+            });
+        }
+        while (num_started < 2) { this_thread::yield(); }
+
+        auto waiter = workers.add_task([&] {
+            for (auto begin = chrono::system_clock::now(); chrono::system_clock::now() - begin < 5s;) {
+                if (sibling_done) { return sibling_seen = true; }
+                this_thread::yield();
+            }
+            return false;
+        });
+        workers.add_task([&] { sibling_done = true; });
+        release = true;
+
+        REQUIRE(waiter->view().wait_for(30s) == future_status::ready);
+        CHECK(sibling_seen);
+    }
+}
+
+TEST_CASE("thread pool bulk tasks", "[thread_pool]") {
+    thread_pool workers{1024, 4};
+
+    // tiled ndarray-like index space, split evenly across workers
+    static constexpr size_t I = 130, J = 70;
+    vector<atomic_int> visited(I * J);
+    vector<atomic_int> chunk_used(7);
+
+    auto t = tiles(array<size_t, 2>{I, J}, {16, 16});
+    auto done = workers.add_bulk_task(
+      t.begin(), t.end(), [&](auto const& tile, size_t chunk) {
+          chunk_used[chunk]++;
+          tile.for_each([&](auto& idx) { visited[idx[0] * J + idx[1]]++; });
+      },
+      chunk_used.size());
+
+    REQUIRE(done.wait_for(30s) == future_status::ready);
+    CHECK(std::all_of(visited.begin(), visited.end(), [](auto& v) { return v == 1; }));
+    CHECK(std::all_of(chunk_used.begin(), chunk_used.end(), [](auto& v) { return v > 0; }));
+
+    iota range(100);
+    auto failed = workers.add_bulk_task(range.begin(), range.end(), [](int i) {
+        if (i == 42) { throw std::runtime_error("42"); }
+    });
+    REQUIRE_THROWS_AS(failed.get(), std::runtime_error);
+
+    iota empty(0);
+    CHECK(workers.add_bulk_task(empty.begin(), empty.end(), [](int) {}).wait_for(0s) == future_status::ready);
+}
+
+TEST_CASE("blocking tasks and sections", "[thread_pool]") {
+    thread_pool workers{1024, 2};
+    atomic_int num_running = 0;
+    atomic_int max_running = 0;
+
+    auto compute = [&]() {
+        auto n = ++num_running;
+        for (auto m = max_running.load(); m < n && !max_running.compare_exchange_weak(m, n);) {}
+        this_thread::sleep_for(1ms);
+        --num_running;
+        return 0;
+    };
+
+    SECTION("blocking tasks don't occupy compute workers") {
+        auto begin = chrono::system_clock::now();
+        vector<std::shared_ptr<future_proxy<int>>> futures;
+        for (int i = 0; i < 16; ++i) {
+            futures.push_back(workers.add_blocking_task([]() { return this_thread::sleep_for(100ms), 1; }));
+        }
+        for (int i = 0; i < 16; ++i) { futures.push_back(workers.add_task(compute)); }
+        for (auto& f : futures) { f->get(); }
+
+        CHECK(chrono::system_clock::now() - begin < 1s);
+        CHECK(workers.num_workers() == 2);
+        CHECK(max_running <= 2);
+    }
+
+    SECTION("blocking section hands over compute slot") {
+        atomic_int num_blocked = 0;
+        auto blocker = workers.add_task([&]() {
+            blocking_section _;
+            num_blocked = (int)workers.num_blocked_workers();
+            this_thread::sleep_for(300ms);
+            return 0;
+        });
+
+        this_thread::sleep_for(50ms);
+        vector<std::shared_ptr<future_proxy<int>>> futures;
+        for (int i = 0; i < 64; ++i) { futures.push_back(workers.add_task(compute)); }
+        for (auto& f : futures) { f->get(); }
+
+        CHECK(blocker->view().wait_for(0s) != std::future_status::ready);
+        CHECK(max_running == 2);
+        blocker->get();
+
+        CHECK(num_blocked == 1);
+        CHECK(workers.num_blocked_workers() == 0);
+
+        // spare worker, which took over the slot, retires once the section is over
+        for (auto begin = chrono::system_clock::now(); workers.num_workers() != 2;) {
+            REQUIRE(chrono::system_clock::now() - begin < 5s);
+            workers.add_task([] { return 0; });
+            this_thread::sleep_for(1ms);
+        }
+        CHECK(workers.num_workers() == 2);
+    }
+
+    SECTION("stalled queue doesn't grow compute workers") {
+        workers.max_stall_interval_time = 1ms;
+        workers.max_task_interval_time = 1ms;
+        workers.max_task_wait_time = 1ms;
+
+        // every worker is stuck, thus queued tasks wait far longer than thresholds
+        vector<std::shared_ptr<future_proxy<int>>> futures;
+        for (int i = 0; i < 2; ++i) {
+            futures.push_back(workers.add_task([]() { return this_thread::sleep_for(100ms), 0; }));
+        }
+        this_thread::sleep_for(10ms);
+        for (int i = 0; i < 64; ++i) {
+            futures.push_back(workers.add_task(compute));
+            this_thread::sleep_for(1ms);
+        }
+        for (auto& f : futures) { f->get(); }
+
+        CHECK(workers.num_workers() == 2);
+        CHECK(max_running <= 2);
+    }
+}
+template <typename Pool_>
+concept dumps_trace = requires(Pool_& pool, std::ostream& os) { pool.dump_trace(os); };
+
+TEST_CASE("thread pool without trace", "[thread_pool]") {
+    // compiled out trace leaves neither per-task id nor dump entry
+    static_assert(sizeof(thread_pool::task_t) == sizeof(thread_pool::task_function_type) + sizeof(thread_pool::clock::time_point));
+    static_assert(!dumps_trace<thread_pool>);
+
+    thread_pool workers{1024, 2};
+    CHECK(workers.add_task([] { return 1; })->get() == 1);
+}
+} // namespace kangsw::thread_pool_test
@@ -0,0 +1,73 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * <ki6080@gmail.com> wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.      Seungwoo Kang.
+ * ----------------------------------------------------------------------------
+ */
+// tracing is enabled only in this unit, thus other units test the compiled out path.
+#define KANGSW_THREAD_POOL_TRACE 1
+
+#include <set>
+#include <sstream>
+#include <kangsw/thread/thread_pool.hxx>
+#include "catch.hpp"
+
+using namespace kangsw;
+using namespace std;
+namespace kangsw::thread_pool_test {
+TEST_CASE("thread pool trace", "[thread_pool]") {
+    static constexpr int NUM_CASE = 100;
+    thread_pool workers{1024, 4};
+
+    atomic_int num_done = 0;
+    for (int i = 0; i < NUM_CASE; ++i) {
+        workers.add_task([&] { this_thread::sleep_for(100us), num_done++; });
+
+        // dumping while workers write must not tear records
+        if (i % 10 == 0) {
+            std::ostringstream os;
+            workers.dump_trace(os);
+            REQUIRE(os.str().starts_with("{\"traceEvents\":["));
+        }
+    }
+
+    auto count_in = [](std::string const& trace, std::string const& phase) {
+        size_t n = 0;
+        for (auto pos = trace.find(phase); pos != trace.npos; pos = trace.find(phase, pos + 1)) { ++n; }
+        return n;
+    };
+
+    // finish events are recorded after the task returns, thus poll until every one appears
+    std::string trace;
+    for (auto begin = chrono::system_clock::now();; this_thread::sleep_for(1ms)) {
+        REQUIRE(chrono::system_clock::now() - begin < 30s);
+        if (num_done < NUM_CASE) { continue; }
+
+        std::ostringstream os;
+        workers.dump_trace(os);
+        trace = os.str();
+        if (count_in(trace, "\"ph\":\"E\"") == NUM_CASE) { break; }
+    }
+    CHECK(trace.ends_with("],\"displayTimeUnit\":\"ns\"}\n"));
+
+    // every task has a flow from its enqueue to its start, and balanced begin/end
+    auto ids_of = [&](std::string const& event) {
+        std::multiset<uint64_t> ids;
+        std::string const key = "\"name\":\"task\",\"cat\":\"thread_pool\",\"ph\":\"" + event + "\"";
+        for (auto pos = trace.find(key); pos != trace.npos; pos = trace.find(key, pos + 1)) {
+            auto const id = trace.find("\"id\":", pos);
+            ids.insert(std::stoull(trace.substr(id + 5)));
+        }
+        return ids;
+    };
+
+    auto const enqueued = ids_of("s");
+    CHECK(enqueued.size() == NUM_CASE);
+    CHECK(std::set<uint64_t>(enqueued.begin(), enqueued.end()).size() == NUM_CASE);
+    CHECK(ids_of("f") == enqueued);
+    CHECK(count_in(trace, "\"ph\":\"B\"") == NUM_CASE);
+    CHECK(count_in(trace, "\"ph\":\"E\"") == NUM_CASE);
+}
+} // namespace kangsw::thread_pool_test